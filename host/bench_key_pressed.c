@@ -0,0 +1,102 @@
+// Host benchmark of KYPD_getKeyPressed and KYPD_getKeysPressed, which use
+// popcount and count trailing zeros, against the original 16-step loop,
+// over all 65536 keystates.
+
+#include <stdio.h>
+
+#include "host.h"
+#include "original.h"
+#include "pmodkypd.h"
+#include "xparameters.h"
+
+/************************** Constant Definitions ************************/
+
+#define BENCH_ROUNDS 1000
+
+/************************** Function Definitions ************************/
+
+// The original loop, extended to list every pressed key
+static u32 LoopKeysPressed(PmodKYPD *InstancePtr, u16 keystate, u8 keys[16]) {
+   u32 count = 0;
+   u8 i;
+
+   for (i = 0; i < 16; i++) {
+      if (0x1 == (keystate & 0x1))
+         keys[count++] = InstancePtr->keytable[i];
+      keystate >>= 1;
+   }
+   return count;
+}
+
+// Prints the mean time of one KYPD_getKeyPressed style call over
+// BENCH_ROUNDS sweeps of every keystate
+static void BenchPressed(const char *name,
+      u32 (*Pressed)(PmodKYPD *InstancePtr, u16 keystate, u8 *cptr),
+      PmodKYPD *InstancePtr) {
+   volatile u32 sink;
+   u32 sum = 0;
+   u64 start;
+   u32 round, keystate;
+   u8 c = 0;
+
+   start = HOST_nsNow();
+   for (round = 0; round < BENCH_ROUNDS; round++)
+      for (keystate = 0; keystate < 0x10000; keystate++)
+         sum += Pressed(InstancePtr, keystate, &c) + c;
+   printf("%-36s %8.2f\n", name,
+         (double) (HOST_nsNow() - start) / BENCH_ROUNDS / 0x10000);
+   sink = sum;
+   (void) sink;
+}
+
+// The same for KYPD_getKeysPressed style calls
+static void BenchKeys(const char *name,
+      u32 (*Keys)(PmodKYPD *InstancePtr, u16 keystate, u8 keys[16]),
+      PmodKYPD *InstancePtr) {
+   volatile u32 sink;
+   u32 sum = 0;
+   u64 start;
+   u32 round, keystate;
+   u8 keys[16];
+
+   start = HOST_nsNow();
+   for (round = 0; round < BENCH_ROUNDS; round++)
+      for (keystate = 0; keystate < 0x10000; keystate++)
+         sum += Keys(InstancePtr, keystate, keys) + keys[0];
+   printf("%-36s %8.2f\n", name,
+         (double) (HOST_nsNow() - start) / BENCH_ROUNDS / 0x10000);
+   sink = sum;
+   (void) sink;
+}
+
+int main(void) {
+   PmodKYPD kypd;
+   u8 keytable[16] = "0FED789C456B123A";
+   u8 keys[16], loop[16];
+   u32 keystate, count, i;
+   u8 c, original;
+
+   KYPD_begin(&kypd, XPAR_AXI_KEYPAD_BASEADDR);
+   KYPD_loadKeyTable(&kypd, keytable);
+
+   for (keystate = 0; keystate < 0x10000; keystate++) {
+      c = original = 0;
+      HOST_check(KYPD_getKeyPressed(&kypd, keystate, &c)
+            == ORIG_getKeyPressed(&kypd, keystate, &original) && c == original,
+            "KYPD_getKeyPressed classifies like the original");
+
+      count = KYPD_getKeysPressed(&kypd, keystate, keys);
+      HOST_check(count == LoopKeysPressed(&kypd, keystate, loop),
+            "KYPD_getKeysPressed finds every pressed key");
+      for (i = 0; i < count; i++)
+         HOST_check(keys[i] == loop[i], "KYPD_getKeysPressed lists in order");
+   }
+
+   printf("Time per call over all keystates\n");
+   printf("%-36s %8s\n", "function", "ns");
+   BenchPressed("KYPD_getKeyPressed, original loop", ORIG_getKeyPressed, &kypd);
+   BenchPressed("KYPD_getKeyPressed, popcount/ctz", KYPD_getKeyPressed, &kypd);
+   BenchKeys("KYPD_getKeysPressed, 16-step loop", LoopKeysPressed, &kypd);
+   BenchKeys("KYPD_getKeysPressed, popcount/ctz", KYPD_getKeysPressed, &kypd);
+   return HOST_finish();
+}
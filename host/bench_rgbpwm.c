@@ -0,0 +1,111 @@
+// Host benchmark of RGBPWM_tick: time and GPIO writes per tick of the packed
+// schedule against a per-channel compare, which tests the counter against
+// the duty of each channel on every tick and writes the GPIO every tick.
+// Both must give the LED the same waveform.
+
+#include <stdio.h>
+
+#include "host.h"
+#include "rgbpwm.h"
+
+/************************** Constant Definitions ************************/
+
+#define BENCH_PERIODS 40000
+#define BENCH_CHANNEL 1
+
+/**************************** Type Definitions **************************/
+
+// Per-channel compare PWM: duty[i] ticks on per period for the color bit
+// bits[i]
+typedef struct Compare {
+   XGpio *gpio;
+   u32 duty[3];
+   u32 gate;
+   u32 tick;
+} Compare;
+
+/************************** Variable Definitions ************************/
+
+static const u32 bits[3] = { RGBPWM_RED, RGBPWM_GREEN, RGBPWM_BLUE };
+
+/************************** Function Definitions ************************/
+
+static void CompareTick(Compare *InstancePtr) {
+   u32 out = 0;
+   u32 i;
+
+   for (i = 0; i < 3; i++)
+      if (InstancePtr->tick < InstancePtr->duty[i])
+         out |= bits[i];
+   XGpio_DiscreteWrite(InstancePtr->gpio, BENCH_CHANNEL,
+         out & InstancePtr->gate);
+   InstancePtr->tick = InstancePtr->tick + 1 < RGBPWM_PERIOD
+         ? InstancePtr->tick + 1 : 0;
+}
+
+static void Bench(u32 rgb) {
+   static XGpio gpio;
+   static u32 wave[RGBPWM_PERIOD];
+   ShadowGpio out;
+   RGBPWM pwm;
+   Compare compare = { &gpio, { 0, 0, 0 }, 0xFF, 0 };
+   u32 i, same;
+   u64 start;
+   double ns;
+
+   SGPIO_begin(&out, &gpio);
+   RGBPWM_begin(&pwm, &out, BENCH_CHANNEL);
+   RGBPWM_setColor(&pwm, rgb);
+
+   // One period of the packed schedule, which gives the duty of every
+   // channel for the compare
+   for (i = 0; i < RGBPWM_PERIOD; i++) {
+      RGBPWM_tick(&pwm);
+      wave[i] = gpio.Data[BENCH_CHANNEL - 1];
+      compare.duty[0] += (wave[i] & RGBPWM_RED) != 0;
+      compare.duty[1] += (wave[i] & RGBPWM_GREEN) != 0;
+      compare.duty[2] += (wave[i] & RGBPWM_BLUE) != 0;
+   }
+
+   same = 1;
+   for (i = 0; i < RGBPWM_PERIOD; i++) {
+      CompareTick(&compare);
+      same &= gpio.Data[BENCH_CHANNEL - 1] == wave[i];
+   }
+   HOST_check(same, "packed schedule matches the per-channel compare");
+
+   printf("%06X %3u %3u %3u", (unsigned) rgb, (unsigned) compare.duty[0],
+         (unsigned) compare.duty[1], (unsigned) compare.duty[2]);
+
+   HOST_resetCounts();
+   start = HOST_nsNow();
+   for (i = 0; i < BENCH_PERIODS * RGBPWM_PERIOD; i++)
+      RGBPWM_tick(&pwm);
+   ns = (double) (HOST_nsNow() - start) / (BENCH_PERIODS * RGBPWM_PERIOD);
+   printf(" %8.4f %7.2f", (double) HostGpioWrites
+         / (BENCH_PERIODS * RGBPWM_PERIOD), ns);
+
+   HOST_resetCounts();
+   start = HOST_nsNow();
+   for (i = 0; i < BENCH_PERIODS * RGBPWM_PERIOD; i++)
+      CompareTick(&compare);
+   ns = (double) (HOST_nsNow() - start) / (BENCH_PERIODS * RGBPWM_PERIOD);
+   printf(" %8.4f %7.2f\n", (double) HostGpioWrites
+         / (BENCH_PERIODS * RGBPWM_PERIOD), ns);
+}
+
+int main(void) {
+   static const u32 colors[] = {
+      0x000000, 0xFF0000, 0xFFFFFF, 0x808080, 0xFF8020, 0x4080C0,
+   };
+   u32 i;
+
+   printf("RGBPWM_tick against a per-channel compare, per tick\n");
+   printf("%6s %3s %3s %3s %8s %7s %8s %7s\n", "", "", "", "",
+         "packed", "", "compare", "");
+   printf("%6s %3s %3s %3s %8s %7s %8s %7s\n", "color", "r", "g", "b",
+         "writes", "ns", "writes", "ns");
+   for (i = 0; i < ARRAY_LEN(colors); i++)
+      Bench(colors[i]);
+   return HOST_finish();
+}
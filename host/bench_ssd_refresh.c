@@ -0,0 +1,63 @@
+// Host benchmark of SSD_refresh: time and GPIO writes per call against the
+// number of chained displays and the blanking interval. The cost of a call
+// must not grow with the chain, and no call may write more than once.
+
+#include <stdio.h>
+
+#include "host.h"
+#include "pmodssd.h"
+
+/************************** Constant Definitions ************************/
+
+#define BENCH_CALLS 4000000
+
+/************************** Function Definitions ************************/
+
+static void Bench(u32 displays, u32 blanking) {
+   static XGpio gpio[SSD_MAX_DISPLAYS];
+   PmodSSD ssd;
+   u32 i, calls, writes, most = 0;
+   u64 start;
+
+   SSD_begin(&ssd, &gpio[0], 1);
+   for (i = 1; i < displays; i++)
+      SSD_addDisplay(&ssd, &gpio[i], 1);
+   SSD_setBlanking(&ssd, blanking);
+   for (i = 0; i < ssd.num_digits; i++) {
+      SSD_setDigit(&ssd, i, SSD_decode('0' + i, 0));
+      SSD_setBrightness(&ssd, i, SSD_BRIGHTNESS_LEVELS / 2 + (i & 1));
+   }
+   SSD_swap(&ssd);
+
+   // Writes of every call over a whole refresh cycle of the chain
+   HOST_resetCounts();
+   calls = 2 * (SSD_BRIGHTNESS_LEVELS + blanking) * displays;
+   for (i = 0; i < calls; i++) {
+      writes = HostGpioWrites;
+      SSD_refresh(&ssd);
+      writes = HostGpioWrites - writes;
+      most = writes > most ? writes : most;
+   }
+   HOST_check(most <= 1, "at most one GPIO write per call");
+
+   printf("%6u %8u %9.3f %10u", ssd.num_digits, blanking,
+         (double) HostGpioWrites / calls, most);
+
+   start = HOST_nsNow();
+   for (i = 0; i < BENCH_CALLS; i++)
+      SSD_refresh(&ssd);
+   printf(" %8.2f\n", (double) (HOST_nsNow() - start) / BENCH_CALLS);
+}
+
+int main(void) {
+   static const u32 blanking[] = { 0, 1, 4 };
+   u32 displays, i;
+
+   printf("SSD_refresh time and GPIO writes per call\n");
+   printf("%6s %8s %9s %10s %8s\n", "digits", "blanking", "writes",
+         "most", "ns");
+   for (i = 0; i < ARRAY_LEN(blanking); i++)
+      for (displays = 1; displays <= SSD_MAX_DISPLAYS; displays++)
+         Bench(displays, blanking[i]);
+   return HOST_finish();
+}
@@ -0,0 +1,28 @@
+#ifndef HOST_H
+#define HOST_H
+
+/****************************** Include Files ***************************/
+
+#include "xil_types.h"
+
+/************************** Constant Definitions ************************/
+
+#define ARRAY_LEN(array) (sizeof(array) / sizeof((array)[0]))
+
+/************************** Variable Definitions ************************/
+
+// Simulated Pmod KYPD behind Xil_In32/Xil_Out32: bit n of HostKeys holds
+// key n down. Every register access is counted, and so is every GPIO write.
+extern u16 HostKeys;
+extern u32 HostReads;
+extern u32 HostWrites;
+extern u32 HostGpioWrites;
+
+/************************** Function Definitions ************************/
+
+void HOST_resetCounts(void);
+u64 HOST_nsNow(void);
+u32 HOST_check(u32 ok, const char *what);
+int HOST_finish(void);
+
+#endif // HOST_H
@@ -0,0 +1,124 @@
+#include "original.h"
+
+/************************** Function Definitions ************************/
+
+// pmodkypd.c
+
+u8 ORIG_lookupShiftPattern(u16 shift) {
+   switch (shift) {
+   case 0xFFFF: return 0x0;
+   case 0x00FF: return 0x1;
+   case 0x0F0F: return 0x2;
+   case 0x0FFF: return 0x3;
+   case 0x3333: return 0x4;
+   case 0x33FF: return 0x5;
+   case 0x3F3F: return 0x6;
+   case 0x033F: return 0x7;
+   case 0x5555: return 0x8;
+   case 0x55FF: return 0x9;
+   case 0x5F5F: return 0xA;
+   case 0x055F: return 0xB;
+   case 0x7777: return 0xC;
+   case 0x1177: return 0xD;
+   case 0x1717: return 0xE;
+   case 0x177F: return 0xF;
+   default:     return 0x0;
+   }
+}
+
+u16 ORIG_getKeyStates(PmodKYPD *InstancePtr) {
+   u32 rows, cols;
+   u16 keystate;
+   u16 shift[4] = {0, 0, 0, 0};
+
+   for (cols = 0; cols < 16; cols++) {
+      Xil_Out32(InstancePtr->GPIO_addr, cols & 0xF);
+      rows = (Xil_In32(InstancePtr->GPIO_addr) >> 4) & 0xF;
+      shift[0] = (shift[0] << 1) | (rows & 0x1);
+      shift[1] = (shift[1] << 1) | (rows & 0x2) >> 1;
+      shift[2] = (shift[2] << 1) | (rows & 0x4) >> 2;
+      shift[3] = (shift[3] << 1) | (rows & 0x8) >> 3;
+   }
+
+   keystate = 0;
+   keystate |= ORIG_lookupShiftPattern(shift[0]);
+   keystate |= ORIG_lookupShiftPattern(shift[1]) << 4;
+   keystate |= ORIG_lookupShiftPattern(shift[2]) << 8;
+   keystate |= ORIG_lookupShiftPattern(shift[3]) << 12;
+   return keystate;
+}
+
+u32 ORIG_getKeyPressed(PmodKYPD *InstancePtr, u16 keystate, u8 *cptr) {
+   u8 i = 0;
+   u8 ci = 0;
+   u32 count = 0;
+
+   for (i = 0; i < 16; i++) {
+      // If key reading is 0 (pressed)
+      if (0x1 == (keystate & 0x1)) {
+         count++; // Count the number of pressed keys
+         ci = i;
+      }
+      // Increment through keystate bits
+      keystate >>= 1;
+   }
+
+   if (count > 1) {
+      // Multiple keys pressed, cannot differentiate which
+      return KYPD_MULTI_KEY;
+   } else if (count == 0) {
+      // No key pressed
+      return KYPD_NO_KEY;
+   } else {
+      // One key pressed
+      if (InstancePtr->keytable_loaded == TRUE)
+         *cptr = InstancePtr->keytable[ci]; // Return human-readable key label
+      else
+         *cptr = ci; // Return index of pressed key
+      return KYPD_SINGLE_KEY;
+   }
+}
+
+// lab_1_part_2.c
+
+u32 ORIG_SSD_decode(u8 key_value, u8 cathode)
+{
+    u32 result;
+
+    // key_value is the ASCII code of the pressed key
+	// The switch statement maps each ASCII code to the corresponding
+	// 7-segment display encoding. The 7-segment display encoding is
+	// represented as a binary number where each bit corresponds to a segment.
+	// A bit value of 1 means the segment is on, and 0 means it's off.
+    switch(key_value){
+        case 48: result = 0b00111111; break; // 0
+        case 49: result = 0b00110000; break; // 1
+        case 50: result = 0b01011011; break; // 2
+        case 51: result = 0b01111001; break; // 3
+        case 52: result = 0b01110100; break; // 4
+        case 53: result = 0b01101101; break; // 5
+        case 54: result = 0b01101111; break; // 6
+        case 55: result = 0b00111000; break; // 7
+        case 56: result = 0b01111111; break; // 8
+        case 57: result = 0b01111100; break; // 9
+        case 65: result = 0b01111110; break; // A
+        case 66: result = 0b01100111; break; // B
+        case 67: result = 0b00001111; break; // C
+        case 68: result = 0b01110011; break; // D
+        case 69: result = 0b01001111; break; // E
+        case 70: result = 0b01001110; break; // F
+        default: result = 0b00000000; break; // Undefined, all segments are OFF
+    }
+
+    // cathode determines which of the two 7-segment displays is active.
+	// - A cathode value of 1 activates the right display
+	// - A cathode value of 0 activates the left display
+	// The Most Significant Bit (MSB) is used as the control bit to select the display.
+	// The MSB is set to 1 for the right display and left as 0 for the left display.
+    if(cathode==0){
+    	return result; // MSB is 0, left display active
+    }
+    else {
+    	return result | 0b10000000; // MSB is set to 1, right display active
+    }
+}
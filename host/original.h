@@ -0,0 +1,19 @@
+#ifndef ORIGINAL_H
+#define ORIGINAL_H
+
+// The driver code as it was before it was optimized, kept for the
+// benchmarks to compare against and check the new code with
+
+/****************************** Include Files ***************************/
+
+#include "pmodkypd.h"
+#include "xil_types.h"
+
+/************************** Function Definitions ************************/
+
+u8 ORIG_lookupShiftPattern(u16 shift);
+u16 ORIG_getKeyStates(PmodKYPD *InstancePtr);
+u32 ORIG_getKeyPressed(PmodKYPD *InstancePtr, u16 keystate, u8 *cptr);
+u32 ORIG_SSD_decode(u8 key_value, u8 cathode);
+
+#endif // ORIGINAL_H
@@ -0,0 +1,9 @@
+#ifndef SLEEP_H
+#define SLEEP_H
+
+// Host stand-in: the simulated keypad settles at once, so this returns
+// without waiting
+
+int usleep(unsigned long useconds);
+
+#endif // SLEEP_H
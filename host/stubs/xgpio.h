@@ -0,0 +1,17 @@
+#ifndef XGPIO_H
+#define XGPIO_H
+
+// Host stand-in: writes are kept in the instance, reads return them
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+typedef struct XGpio {
+   u32 BaseAddress;
+   u32 Data[2];
+} XGpio;
+
+u32 XGpio_DiscreteRead(XGpio *InstancePtr, unsigned Channel);
+void XGpio_DiscreteWrite(XGpio *InstancePtr, unsigned Channel, u32 Data);
+
+#endif // XGPIO_H
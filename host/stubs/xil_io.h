@@ -0,0 +1,12 @@
+#ifndef XIL_IO_H
+#define XIL_IO_H
+
+// Host stand-in: register accesses go to the simulated keypad in stubs.c,
+// which counts them
+
+#include "xil_types.h"
+
+u32 Xil_In32(u32 Addr);
+void Xil_Out32(u32 Addr, u32 Value);
+
+#endif // XIL_IO_H
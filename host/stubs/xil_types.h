@@ -0,0 +1,23 @@
+#ifndef XIL_TYPES_H
+#define XIL_TYPES_H
+
+// Host stand-in for the Xilinx standalone BSP types
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef int64_t  s64;
+
+typedef void (*Xil_ExceptionHandler)(void *data);
+
+#define TRUE  1U
+#define FALSE 0U
+
+#endif // XIL_TYPES_H
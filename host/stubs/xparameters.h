@@ -0,0 +1,12 @@
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+
+// Host stand-in with the values of the Zybo Z7-10 hardware platform
+
+#define XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ 666666687
+#define XPAR_CPU_CORTEXA9_CORE_CLOCK_FREQ_HZ 666666687
+#define XPAR_SCUWDT_0_DEVICE_ID 0
+#define XPAR_SCUWDT_INTR 30
+#define XPAR_AXI_KEYPAD_BASEADDR 0x41200000
+
+#endif // XPARAMETERS_H
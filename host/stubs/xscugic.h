@@ -0,0 +1,18 @@
+#ifndef XSCUGIC_H
+#define XSCUGIC_H
+
+// Host stand-in: programs call HWTIMER_tick themselves instead
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+typedef struct XScuGic {
+   u32 IsReady;
+} XScuGic;
+
+s32 XScuGic_Connect(XScuGic *InstancePtr, u32 Int_Id,
+      Xil_ExceptionHandler Handler, void *CallBackRef);
+void XScuGic_Enable(XScuGic *InstancePtr, u32 Int_Id);
+void XScuGic_Disable(XScuGic *InstancePtr, u32 Int_Id);
+
+#endif // XSCUGIC_H
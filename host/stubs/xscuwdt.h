@@ -0,0 +1,36 @@
+#ifndef XSCUWDT_H
+#define XSCUWDT_H
+
+// Host stand-in: the watchdog in timer mode only keeps its registers
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+#define XSCUWDT_CONTROL_IT_ENABLE_MASK   0x00000004U
+#define XSCUWDT_CONTROL_AUTO_RELOAD_MASK 0x00000002U
+#define XSCUWDT_ISR_OFFSET               0x0000000CU
+#define XSCUWDT_ISR_EVENT_FLAG_MASK      0x00000001U
+
+typedef struct XScuWdt_Config {
+   u16 DeviceId;
+   u32 BaseAddr;
+} XScuWdt_Config;
+
+typedef struct XScuWdt {
+   XScuWdt_Config Config;
+   u32 Load;
+   u32 Control;
+} XScuWdt;
+
+XScuWdt_Config *XScuWdt_LookupConfig(u16 DeviceId);
+s32 XScuWdt_CfgInitialize(XScuWdt *InstancePtr, XScuWdt_Config *ConfigPtr,
+      u32 EffectiveAddress);
+void XScuWdt_SetTimerMode(XScuWdt *InstancePtr);
+void XScuWdt_LoadWdt(XScuWdt *InstancePtr, u32 Value);
+u32 XScuWdt_GetControlReg(XScuWdt *InstancePtr);
+void XScuWdt_SetControlReg(XScuWdt *InstancePtr, u32 Value);
+void XScuWdt_Start(XScuWdt *InstancePtr);
+void XScuWdt_Stop(XScuWdt *InstancePtr);
+void XScuWdt_WriteReg(u32 BaseAddr, u32 Offset, u32 Value);
+
+#endif // XSCUWDT_H
@@ -0,0 +1,17 @@
+#ifndef XTIME_L_H
+#define XTIME_L_H
+
+// Host stand-in: the global timer is a counter the programs set themselves
+
+#include "xparameters.h"
+#include "xil_types.h"
+
+typedef u64 XTime;
+
+#define COUNTS_PER_SECOND (XPAR_CPU_CORTEXA9_CORE_CLOCK_FREQ_HZ / 2)
+
+extern XTime HostTime;
+
+void XTime_GetTime(XTime *Xtime_Global);
+
+#endif // XTIME_L_H
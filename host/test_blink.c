@@ -0,0 +1,123 @@
+// Host test of the blink generator: BLINK_sample is driven from a simulated
+// global timer at the rate of the RGB LED interrupt, and every sample must
+// show the level of an ideal blink started at the first sample.
+
+#include <stdio.h>
+
+#include "blink.h"
+#include "host.h"
+#include "xtime_l.h"
+
+/************************** Constant Definitions ************************/
+
+#define SAMPLE_RATE_HZ 32000
+
+/************************** Function Definitions ************************/
+
+// Global timer count of sample n
+static u64 SampleTime(u64 n) {
+   return n * COUNTS_PER_SECOND / SAMPLE_RATE_HZ;
+}
+
+// Samples from sample 'from' to just before 'to' and compares each level
+// with the ideal blink that turned on at count 'start'. Returns the number
+// of rising edges seen.
+static u32 CheckSamples(Blink *InstancePtr, u64 from, u64 to, u64 start,
+      const char *what) {
+   u64 now;
+   u32 level, ideal, last = 1, edges = 0, ok = TRUE;
+
+   for (; from < to; from++) {
+      now = SampleTime(from);
+      level = BLINK_sample(InstancePtr, now);
+      ideal = InstancePtr->run.period == 0
+            || (now - start) % InstancePtr->run.period < InstancePtr->run.on;
+      ok &= level == ideal;
+      edges += level && !last;
+      last = level;
+   }
+   HOST_check(ok, what);
+   return edges;
+}
+
+static void TestSteady(Blink *InstancePtr) {
+   HOST_check(CheckSamples(InstancePtr, 0, SAMPLE_RATE_HZ, 0,
+         "steady on after BLINK_begin") == 0, "no edges while steady");
+   BLINK_setFrequency(InstancePtr, 0, 50);
+   CheckSamples(InstancePtr, 0, SAMPLE_RATE_HZ, 0, "frequency 0 is steady on");
+}
+
+// The period is the nearest whole number of counts and the achieved
+// frequency is that of the period
+static void TestAchieved(Blink *InstancePtr) {
+   static const u32 mhz[] = { 500, 1000, 7000, 30000, 123456, 1000000,
+         4000000 };
+   u64 counts = (u64) COUNTS_PER_SECOND * 1000;
+   u32 achieved, i;
+
+   for (i = 0; i < ARRAY_LEN(mhz); i++) {
+      achieved = BLINK_setFrequency(InstancePtr, mhz[i], 50);
+      BLINK_sample(InstancePtr, 0);
+      HOST_check(achieved == (counts + InstancePtr->run.period / 2)
+            / InstancePtr->run.period, "achieved frequency of the period");
+      HOST_check(2 * (counts > InstancePtr->run.period * mhz[i]
+            ? counts - InstancePtr->run.period * mhz[i]
+            : InstancePtr->run.period * mhz[i] - counts) <= mhz[i],
+            "period rounded to the nearest count");
+   }
+}
+
+// Edges stay on the grid of the period over many periods, so the frequency
+// and duty cycle are exact on average
+static void TestEdges(Blink *InstancePtr, u32 mhz, u32 duty, u32 seconds) {
+   u64 first = 3 * SAMPLE_RATE_HZ;
+   u64 last = first + (u64) seconds * SAMPLE_RATE_HZ;
+   u32 edges;
+
+   BLINK_setFrequency(InstancePtr, mhz, duty);
+   edges = CheckSamples(InstancePtr, first, last, SampleTime(first),
+         "every sample shows the ideal level");
+   // The first period starts on without an edge
+   HOST_check(edges == (SampleTime(last - 1) - SampleTime(first))
+         / InstancePtr->run.period, "one rising edge per period");
+}
+
+// A long gap between samples skips whole periods without shifting them
+static void TestGap(Blink *InstancePtr) {
+   u64 first = 10;
+   u64 gap = first + 1000;
+
+   BLINK_setFrequency(InstancePtr, 3000, 30);
+   CheckSamples(InstancePtr, first, gap, SampleTime(first), "before the gap");
+   CheckSamples(InstancePtr, gap + 37 * SAMPLE_RATE_HZ + 123,
+         gap + 38 * SAMPLE_RATE_HZ, SampleTime(first),
+         "after the gap the edges are still on the grid");
+}
+
+// A new frequency starts a period on at the next sample
+static void TestChange(Blink *InstancePtr) {
+   u64 first = 20;
+   u64 change = first + SAMPLE_RATE_HZ / 3;
+
+   BLINK_setFrequency(InstancePtr, 2000, 50);
+   CheckSamples(InstancePtr, first, change, SampleTime(first),
+         "before the change");
+   BLINK_setFrequency(InstancePtr, 5000, 20);
+   CheckSamples(InstancePtr, change, change + SAMPLE_RATE_HZ,
+         SampleTime(change), "after the change");
+}
+
+int main(void) {
+   Blink blink;
+
+   BLINK_begin(&blink, COUNTS_PER_SECOND);
+   TestSteady(&blink);
+   TestAchieved(&blink);
+   TestEdges(&blink, 1000, 50, 10);
+   TestEdges(&blink, 7000, 25, 10);
+   TestEdges(&blink, 30000, 90, 10);
+   TestEdges(&blink, 1234567, 50, 10);
+   TestGap(&blink);
+   TestChange(&blink);
+   return HOST_finish();
+}
@@ -0,0 +1,50 @@
+// Host test of the keypad row decoding: every key combination of a row is
+// read through KYPD_getKeyStates from the simulated keypad, and the keys it
+// reports as certain must be those all the combinations fitting the pattern
+// agree on.
+
+#include <stdio.h>
+
+#include "host.h"
+#include "pmodkypd.h"
+#include "xparameters.h"
+
+/************************** Constant Definitions ************************/
+
+// Keys known for certain per row pattern, indexed by the buttons held. The
+// patterns of 1, 2, 4 and 8 also fit the combinations adding a key whose
+// column reads mid-rail, and those of 7, B, D and E fit 4 others each,
+// which agree on no key at all.
+static const u8 ExpectedCertain[16] = {
+   0xF, 0x1, 0x2, 0xF, 0x4, 0xF, 0xF, 0x0,
+   0x8, 0xF, 0xF, 0x0, 0xF, 0x0, 0x0, 0xF
+};
+
+/************************** Function Definitions ************************/
+
+int main(void) {
+   PmodKYPD kypd;
+   u32 row, buttons;
+   u16 keystate, certain;
+
+   KYPD_begin(&kypd, XPAR_AXI_KEYPAD_BASEADDR);
+
+   for (row = 0; row < 4; row++) {
+      for (buttons = 0; buttons < 16; buttons++) {
+         HostKeys = buttons << (4 * row);
+         keystate = KYPD_getKeyStates(&kypd);
+         certain = (kypd.confidence >> (4 * row)) & 0xF;
+
+         HOST_check(keystate == HostKeys, "table patterns read their keys");
+         HOST_check(kypd.unknown_rows == 0, "table patterns are known");
+         HOST_check(certain == ExpectedCertain[buttons],
+               "confidence follows the model");
+         HOST_check((kypd.confidence | (0xF << (4 * row))) == 0xFFFF,
+               "idle rows are certain");
+         if (certain != ExpectedCertain[buttons])
+            printf("row %u buttons %X: certain %X, expected %X\n", row,
+                  buttons, certain, ExpectedCertain[buttons]);
+      }
+   }
+   return HOST_finish();
+}
@@ -0,0 +1,168 @@
+// Host test of interrupt driven keypad scanning: HWTIMER_tick runs the
+// incremental scan, the debouncer and KYPD_pollEvents at the rates of the
+// application, against the simulated keypad.
+
+#include <stdio.h>
+
+#include "host.h"
+#include "hwtimer.h"
+#include "pmodkypd.h"
+
+/************************** Constant Definitions ************************/
+
+#define TIMER_RATE_HZ         32000
+#define KYPD_SCAN_HZ          4000
+#define KYPD_DEBOUNCE_SAMPLES 4
+#define KYPD_EVENT_QUEUE_LEN  8
+#define KYPD_HOLD_TICKS       (TIMER_RATE_HZ / 2)
+
+#define DEFAULT_KEYTABLE "0FED789C456B123A"
+
+// Latest a change can be reported: a sweep already under way, then one
+// sweep of 16 steps per debounce sample. Presses and releases alike take
+// at least the sweeps of all but the first sample.
+#define KYPD_LATENCY_TICKS \
+   ((KYPD_DEBOUNCE_SAMPLES + 1) * 16 * (TIMER_RATE_HZ / KYPD_SCAN_HZ))
+#define KYPD_DEBOUNCE_TICKS \
+   ((KYPD_DEBOUNCE_SAMPLES - 1) * 16 * (TIMER_RATE_HZ / KYPD_SCAN_HZ))
+
+/************************** Variable Definitions ************************/
+
+static HWTimer TimerInst;
+static PmodKYPD KYPDInst;
+static KYPD_Debouncer xKeypadDebouncer;
+static KYPD_EventBuffer xKeypadEvents;
+static KYPD_Event xKeypadEventStorage[KYPD_EVENT_QUEUE_LEN];
+
+/************************** Function Definitions ************************/
+
+// KeypadScanISR of the application, without the task notification
+static void KeypadScanISR(void *CallbackRef) {
+   PmodKYPD *InstancePtr = (PmodKYPD *) CallbackRef;
+   u16 keystate;
+
+   if (!KYPD_scanStep(InstancePtr, &keystate))
+      return;
+   keystate = KYPD_debounce(&xKeypadDebouncer, keystate);
+   KYPD_pollEvents(InstancePtr, keystate, TimerInst.ticks, &xKeypadEvents);
+}
+
+static void RunTicks(u32 ticks) {
+   while (ticks-- > 0)
+      HWTIMER_tick(&TimerInst);
+}
+
+// Runs the timer until an event is queued or the latency is over
+static u32 RunUntilEvent(void) {
+   u32 ticks;
+
+   for (ticks = 0; ticks <= KYPD_LATENCY_TICKS; ticks++) {
+      if (xKeypadEvents.head != xKeypadEvents.tail)
+         return TRUE;
+      HWTIMER_tick(&TimerInst);
+   }
+   return FALSE;
+}
+
+static void ExpectEvent(u8 type, u32 key, u16 keystate, const char *what) {
+   KYPD_Event event;
+
+   if (!HOST_check(KYPD_readEvent(&xKeypadEvents, &event), what))
+      return;
+   HOST_check(event.type == type && event.key == key
+         && event.ch == (u8) DEFAULT_KEYTABLE[key]
+         && event.keystate == keystate, what);
+}
+
+static void TestSingleKey(void) {
+   u32 changed;
+
+   HostKeys = 1 << 5;
+   changed = TimerInst.ticks;
+   HOST_check(RunUntilEvent(), "a press is reported within the latency");
+   HOST_check(TimerInst.ticks - changed >= KYPD_DEBOUNCE_TICKS,
+         "a press is debounced");
+   ExpectEvent(KYPD_EVENT_PRESS, 5, 1 << 5, "single key press");
+
+   RunTicks(TIMER_RATE_HZ / 10);
+   HostKeys = 0;
+   changed = TimerInst.ticks;
+   HOST_check(RunUntilEvent(), "a release is reported within the latency");
+   HOST_check(TimerInst.ticks - changed >= KYPD_DEBOUNCE_TICKS,
+         "a release is debounced as long as a press");
+   ExpectEvent(KYPD_EVENT_RELEASE, 5, 0, "single key release");
+}
+
+// A tap released before the reader gets to its press must still read as a
+// single key
+static void TestQuickTap(void) {
+   HostKeys = 1 << 9;
+   RunUntilEvent();
+   HostKeys = 0;
+   RunTicks(KYPD_LATENCY_TICKS);
+   ExpectEvent(KYPD_EVENT_PRESS, 9, 1 << 9, "tap press keeps its keystate");
+   ExpectEvent(KYPD_EVENT_RELEASE, 9, 0, "tap release");
+}
+
+static void TestChord(void) {
+   const u16 chord = (1 << 0) | (1 << 4);
+
+   HostKeys = chord;
+   RunTicks(KYPD_LATENCY_TICKS);
+   ExpectEvent(KYPD_EVENT_PRESS, 0, chord, "chord press of the first key");
+   ExpectEvent(KYPD_EVENT_PRESS, 4, chord, "chord press of the second key");
+   HostKeys = 0;
+   RunTicks(KYPD_LATENCY_TICKS);
+   ExpectEvent(KYPD_EVENT_RELEASE, 0, 0, "chord release of the first key");
+   ExpectEvent(KYPD_EVENT_RELEASE, 4, 0, "chord release of the second key");
+}
+
+static void TestHold(void) {
+   HostKeys = 1 << 12;
+   RunUntilEvent();
+   ExpectEvent(KYPD_EVENT_PRESS, 12, 1 << 12, "press before the hold");
+   RunTicks(KYPD_HOLD_TICKS - KYPD_LATENCY_TICKS);
+   HOST_check(xKeypadEvents.head == xKeypadEvents.tail,
+         "no hold before the hold time");
+   RunTicks(2 * KYPD_LATENCY_TICKS);
+   ExpectEvent(KYPD_EVENT_HOLD, 12, 1 << 12, "hold after the hold time");
+   HostKeys = 0;
+   RunTicks(KYPD_LATENCY_TICKS);
+   ExpectEvent(KYPD_EVENT_RELEASE, 12, 0, "release after the hold");
+}
+
+// A contact bounce shorter than the debounce time must not be reported,
+// even when it lasts a whole sweep
+static void TestBounce(void) {
+   HostKeys = 1 << 3;
+   RunTicks(24 * (TIMER_RATE_HZ / KYPD_SCAN_HZ));
+   HostKeys = 0;
+   RunTicks(4 * KYPD_LATENCY_TICKS);
+   HOST_check(xKeypadEvents.head == xKeypadEvents.tail
+         && xKeypadEvents.dropped == 0, "a bounce is filtered out");
+}
+
+int main(void) {
+   HOST_check(HWTIMER_begin(&TimerInst, XPAR_SCUWDT_0_DEVICE_ID,
+         TIMER_RATE_HZ) == XST_SUCCESS, "timer starts");
+   KYPD_begin(&KYPDInst, XPAR_AXI_KEYPAD_BASEADDR);
+   KYPD_loadKeyTable(&KYPDInst, (u8 *) DEFAULT_KEYTABLE);
+   KYPD_setHoldTime(&KYPDInst, KYPD_HOLD_TICKS);
+   KYPD_debounceInit(&xKeypadDebouncer, KYPD_DEBOUNCE_SAMPLES);
+   KYPD_eventBufferInit(&xKeypadEvents, xKeypadEventStorage,
+         KYPD_EVENT_QUEUE_LEN);
+   HWTIMER_addCallback(&TimerInst, KeypadScanISR, &KYPDInst,
+         TIMER_RATE_HZ / KYPD_SCAN_HZ);
+
+   HostKeys = 0;
+   RunTicks(TIMER_RATE_HZ / 10);
+   HOST_check(xKeypadEvents.head == xKeypadEvents.tail,
+         "an idle keypad reports nothing");
+
+   TestSingleKey();
+   TestQuickTap();
+   TestChord();
+   TestHold();
+   TestBounce();
+   return HOST_finish();
+}
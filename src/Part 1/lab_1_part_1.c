@@ -12,6 +12,7 @@
 
 // Other miscellaneous libraries
 #include "pmodkypd.h"
+#include "pmodssd.h"
 #include "sleep.h"
 #include "xil_cache.h"
 
@@ -39,7 +40,6 @@ XGpio SSDInst;
 // Function prototypes
 void InitializeKeypad();
 static void keypadTask( void *pvParameters );
-u32 SSD_decode(u8 key_value, u8 cathode);
 
 int main(void)
 {
@@ -138,38 +138,4 @@ void InitializeKeypad()
 {
    KYPD_begin(&KYPDInst, XPAR_AXI_KEYPAD_BASEADDR);
    KYPD_loadKeyTable(&KYPDInst, (u8*) DEFAULT_KEYTABLE);
-}
-
-// This function is hard coded to translate key value codes to their binary representation
-u32 SSD_decode(u8 key_value, u8 cathode)
-{
-    u32 result;
-
-	// key_value represents the code of the pressed key
-    switch(key_value){ // Handles the coding of the 7-seg display
-        case 48: result = 0b00111111; break; // 0
-        case 49: result = 0b00110000; break; // 1
-        case 50: result = 0b01011011; break; // 2
-        case 51: result = 0b01111001; break; // 3
-        case 52: result = 0b01110100; break; // 4
-        case 53: result = 0b01101101; break; // 5
-        case 54: result = 0b01101111; break; // 6
-        case 55: result = 0b00111000; break; // 7
-        case 56: result = 0b01111111; break; // 8
-        case 57: result = 0b01111100; break; // 9
-        case 65: result = 0b01111110; break; // A
-        case 66: result = 0b01100111; break; // B
-        case 67: result = 0b00001111; break; // C
-        case 68: result = 0b01110011; break; // D
-        case 69: result = 0b01001111; break; // E
-        case 70: result = 0b01001110; break; // F
-        default: result = 0b00000000; break; // default case - all seven segments are OFF
-    }
-
-	// cathode handles which display is active (left or right)
-	// by setting the MSB to 1 or 0
-    if(cathode==0)
-            return result;
-        else
-            return result | 0b10000000;
 }
\ No newline at end of file
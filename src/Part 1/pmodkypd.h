@@ -11,14 +11,81 @@
 
 typedef struct PmodKYPD {
    u32 GPIO_addr;
+   u32 cols;
+   u32 writes_avoided;
    u8  keytable[16];
    u32 keytable_loaded;
+   u8  unknown_rows;
+   u16 confidence;
+   u8  scan_step;
+   u8  idle_steps;
+   u16 shift[4];
+   u16 last_keystate;
+   u16 held_keys;
+   u32 hold_ticks;
+   u32 press_tick[16];
+   u16 cal_pattern[16];
+   u16 cal_captured;
+   u32 cal_loaded;
+   u32 settle_us;
 } PmodKYPD;
 
+// One key transition reported by KYPD_pollEvents, with the keystate it was
+// found in
+typedef struct KYPD_Event {
+   u8  type;
+   u8  key;
+   u8  ch;
+   u16 keystate;
+   u32 tick;
+} KYPD_Event;
+
+// Caller-supplied single-producer/single-consumer ring of key events.
+// head and tail run freely and are masked on access.
+typedef struct KYPD_EventBuffer {
+   KYPD_Event *events;
+   u32 mask;
+   volatile u32 head;
+   volatile u32 tail;
+   u32 dropped;
+} KYPD_EventBuffer;
+
+// Vertical-counter debouncer for the 16-bit keystate. Bit n of count[0..2]
+// together form the 3-bit counter of key n.
+typedef struct KYPD_Debouncer {
+   u16 state;
+   u16 count[3];
+   u16 match[3];
+} KYPD_Debouncer;
+
 #define KYPD_NO_KEY     0
 #define KYPD_SINGLE_KEY 1
 #define KYPD_MULTI_KEY  2
 
+// Column pattern driving every column low, and the row reading seen when no
+// key is pulling a row down (rows are active low).
+#define KYPD_ALL_COLS   0x0
+#define KYPD_ROWS_IDLE  0xF
+
+// Column shadow value before the first write, never equal to a real pattern
+#define KYPD_COLS_UNKNOWN 0xFFFFFFFF
+
+// Returned by the shift pattern lookup for a row reading that matches no known
+// key combination. Kept distinct from 0x0, which means no key on that row.
+#define KYPD_UNKNOWN_PATTERN 0x10
+
+#define KYPD_EVENT_NONE    0
+#define KYPD_EVENT_PRESS   1
+#define KYPD_EVENT_RELEASE 2
+#define KYPD_EVENT_HOLD    3
+
+// Largest debounce sample count representable by the 3-bit vertical counters
+#define KYPD_DEBOUNCE_MAX 8
+
+// Calibration: sweeps that must agree, and the longest settle time tried
+#define KYPD_CAL_REPEATS       8
+#define KYPD_CAL_SETTLE_MAX_US 100
+
 /************************** Function Definitions ************************/
 
 void KYPD_begin(PmodKYPD *InstancePtr, u32 GPIO_Address);
@@ -26,6 +93,19 @@ void KYPD_loadKeyTable(PmodKYPD *InstancePtr, u8 keytable[16]);
 void KYPD_setCols(PmodKYPD *InstancePtr, u32 cols);
 u32 KYPD_getRows(PmodKYPD *InstancePtr);
 u16 KYPD_getKeyStates(PmodKYPD *InstancePtr);
+u32 KYPD_scanStep(PmodKYPD *InstancePtr, u16 *keystate);
 u32 KYPD_getKeyPressed(PmodKYPD *InstancePtr, u16 keystate, u8 *cptr);
+u32 KYPD_getKeysPressed(PmodKYPD *InstancePtr, u16 keystate, u8 keys[16]);
+void KYPD_debounceInit(KYPD_Debouncer *DebouncePtr, u32 samples);
+u16 KYPD_debounce(KYPD_Debouncer *DebouncePtr, u16 keystate);
+void KYPD_eventBufferInit(KYPD_EventBuffer *BufferPtr, KYPD_Event *events,
+      u32 size);
+u32 KYPD_readEvent(KYPD_EventBuffer *BufferPtr, KYPD_Event *EventPtr);
+void KYPD_setHoldTime(PmodKYPD *InstancePtr, u32 ticks);
+u32 KYPD_pollEvents(PmodKYPD *InstancePtr, u16 keystate, u32 tick,
+      KYPD_EventBuffer *BufferPtr);
+void KYPD_calibrateBegin(PmodKYPD *InstancePtr);
+XStatus KYPD_calibrateKey(PmodKYPD *InstancePtr, u32 key, u32 *settle_us);
+XStatus KYPD_calibrateEnd(PmodKYPD *InstancePtr);
 
 #endif // PmodKYPD_H
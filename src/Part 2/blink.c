@@ -0,0 +1,111 @@
+#include "blink.h"
+
+/************************** Function Definitions ************************/
+
+/* -------------------------------------------------------------------- */
+/*** void BLINK_begin(Blink *InstancePtr, u32 clock_hz)
+**
+**   Parameters:
+**      InstancePtr: A Blink to start
+**      clock_hz:    Counts per second of the time source passed to
+**                   BLINK_sample
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Initialize the generator steady on. The time source only has to
+**      count up freely; on the board it is the global timer, on a host any
+**      simulated counter will do.
+*/
+void BLINK_begin(Blink *InstancePtr, u32 clock_hz) {
+   InstancePtr->clock_hz = clock_hz;
+   InstancePtr->config[0].period = 0;
+   InstancePtr->config[0].on = 0;
+   InstancePtr->generation = 0;
+   InstancePtr->applied = 0;
+   InstancePtr->run.period = 0;
+   InstancePtr->run.on = 0;
+   InstancePtr->next_edge = 0;
+   InstancePtr->level = 1;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 BLINK_setFrequency(Blink *InstancePtr, u32 mhz, u32 duty)
+**
+**   Parameters:
+**      InstancePtr: A Blink to use
+**      mhz:         Blink frequency in millihertz, or 0 for steady on
+**      duty:        Percentage of the period that is on, 0 to 100
+**
+**   Return Value:
+**      mhz: The frequency achieved, in millihertz
+**
+**   Description:
+**      Round the period to whole counts of the time source and return the
+**      frequency that period really gives; the on time is rounded the same
+**      way. The change takes effect at the next BLINK_sample, which starts
+**      a new period on. Only one task may set the frequency at a time.
+*/
+u32 BLINK_setFrequency(Blink *InstancePtr, u32 mhz, u32 duty) {
+   u64 counts = (u64) InstancePtr->clock_hz * 1000;
+   u64 period = 0;
+   u64 on = 0;
+   u32 i;
+
+   if (mhz != 0) {
+      period = (counts + mhz / 2) / mhz;
+      if (period == 0)
+         period = 1;
+      on = (period * (duty > 100 ? 100 : duty) + 50) / 100;
+   }
+
+   i = (InstancePtr->generation + 1) & 1;
+   InstancePtr->config[i].period = period;
+   InstancePtr->config[i].on = on;
+   InstancePtr->generation++;
+
+   return period == 0 ? 0 : (u32) ((counts + period / 2) / period);
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 BLINK_sample(Blink *InstancePtr, u64 now)
+**
+**   Parameters:
+**      InstancePtr: A Blink to use
+**      now:         Current count of the time source
+**
+**   Return Value:
+**      level: 1 while the blink is on, 0 while it is off
+**
+**   Description:
+**      Step over the edges passed since the last call, normally one at
+**      most when it is called from a periodic interrupt several times per
+**      period. Only after a long gap, such as a stop in the debugger, are
+**      whole periods skipped with a division.
+*/
+u32 BLINK_sample(Blink *InstancePtr, u64 now) {
+   u32 generation = InstancePtr->generation;
+   u64 late;
+
+   if (generation != InstancePtr->applied) {
+      InstancePtr->applied = generation;
+      InstancePtr->run.period = InstancePtr->config[generation & 1].period;
+      InstancePtr->run.on = InstancePtr->config[generation & 1].on;
+      InstancePtr->next_edge = now + InstancePtr->run.on;
+      InstancePtr->level = 1;
+   }
+   if (InstancePtr->run.period == 0)
+      return 1;
+
+   if ((s64) (now - InstancePtr->next_edge) >= (s64) InstancePtr->run.period) {
+      late = now - InstancePtr->next_edge;
+      InstancePtr->next_edge += late - late % InstancePtr->run.period;
+   }
+   while ((s64) (now - InstancePtr->next_edge) >= 0) {
+      InstancePtr->level ^= 1;
+      InstancePtr->next_edge += InstancePtr->level ? InstancePtr->run.on
+            : InstancePtr->run.period - InstancePtr->run.on;
+   }
+   return InstancePtr->level;
+}
@@ -0,0 +1,39 @@
+#ifndef BLINK_H
+#define BLINK_H
+
+/****************************** Include Files ***************************/
+
+#include "xil_types.h"
+
+/**************************** Type Definitions **************************/
+
+// Lengths of one blink period and of its on part, in counts of the time
+// source. A period of 0 means steady on.
+typedef struct BLINK_Config {
+   u64 period;
+   u64 on;
+} BLINK_Config;
+
+// Blink generator timed by a free-running counter. The edges are placed on
+// exact multiples of the period counted from the start, so sampling late
+// delays an edge but never shifts the ones after it: the frequency and
+// duty cycle stay exact on average. BLINK_setFrequency writes the back
+// config and publishes it by bumping generation; BLINK_sample restarts
+// from the new config when it sees the change.
+typedef struct Blink {
+   u32 clock_hz;
+   volatile BLINK_Config config[2];
+   volatile u32 generation;
+   u32 applied;
+   BLINK_Config run;
+   u64 next_edge;
+   u32 level;
+} Blink;
+
+/************************** Function Definitions ************************/
+
+void BLINK_begin(Blink *InstancePtr, u32 clock_hz);
+u32 BLINK_setFrequency(Blink *InstancePtr, u32 mhz, u32 duty);
+u32 BLINK_sample(Blink *InstancePtr, u64 now);
+
+#endif // BLINK_H
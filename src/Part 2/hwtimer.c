@@ -0,0 +1,174 @@
+#include "hwtimer.h"
+
+/*************************** Function Prototypes ************************/
+
+static void HWTIMER_intrHandler(void *CallbackRef);
+
+/************************** Function Definitions ************************/
+
+/* -------------------------------------------------------------------- */
+/*** XStatus HWTIMER_begin(HWTimer *InstancePtr, u16 DeviceId, u32 rate_hz)
+**
+**   Parameters:
+**      InstancePtr: A HWTimer to initialize
+**      DeviceId:    Device ID of the SCU private watchdog
+**      rate_hz:     Interrupt rate of the timebase
+**
+**   Return Value:
+**      status: XST_SUCCESS, or the error of the watchdog driver
+**
+**   Description:
+**      Put the SCU private watchdog in auto-reloading timer mode at the
+**      requested rate. The timer does not run until HWTIMER_start.
+*/
+XStatus HWTIMER_begin(HWTimer *InstancePtr, u16 DeviceId, u32 rate_hz) {
+   XScuWdt_Config *ConfigPtr;
+   XStatus status;
+
+   InstancePtr->rate_hz = rate_hz;
+   InstancePtr->ticks = 0;
+   InstancePtr->num_callbacks = 0;
+
+   ConfigPtr = XScuWdt_LookupConfig(DeviceId);
+   if (ConfigPtr == NULL)
+      return XST_DEVICE_NOT_FOUND;
+
+   status = XScuWdt_CfgInitialize(&InstancePtr->wdt, ConfigPtr,
+         ConfigPtr->BaseAddr);
+   if (status != XST_SUCCESS)
+      return status;
+
+   XScuWdt_SetTimerMode(&InstancePtr->wdt);
+   XScuWdt_LoadWdt(&InstancePtr->wdt, HWTIMER_CLOCK_HZ / rate_hz - 1);
+   return XST_SUCCESS;
+}
+
+/* -------------------------------------------------------------------- */
+/*** XStatus HWTIMER_addCallback(HWTimer *InstancePtr,
+**                               HWTIMER_Callback Callback,
+**                               void *CallbackRef, u32 divider)
+**
+**   Parameters:
+**      InstancePtr: A HWTimer to use
+**      Callback:    Function to call from the timer interrupt
+**      CallbackRef: Argument passed to Callback
+**      divider:     Callback runs once every 'divider' timer ticks
+**
+**   Return Value:
+**      status: XST_SUCCESS, or XST_FAILURE when the callback table is full
+**
+**   Description:
+**      Register a periodic callback. Must be called before HWTIMER_start.
+*/
+XStatus HWTIMER_addCallback(HWTimer *InstancePtr, HWTIMER_Callback Callback,
+      void *CallbackRef, u32 divider) {
+   u32 i = InstancePtr->num_callbacks;
+
+   if (i >= HWTIMER_MAX_CALLBACKS)
+      return XST_FAILURE;
+
+   InstancePtr->callback[i] = Callback;
+   InstancePtr->callback_ref[i] = CallbackRef;
+   InstancePtr->divider[i] = divider ? divider : 1;
+   InstancePtr->countdown[i] = InstancePtr->divider[i];
+   InstancePtr->num_callbacks = i + 1;
+   return XST_SUCCESS;
+}
+
+/* -------------------------------------------------------------------- */
+/*** XStatus HWTIMER_start(HWTimer *InstancePtr, XScuGic *IntcPtr,
+**                         u32 IntrId)
+**
+**   Parameters:
+**      InstancePtr: A HWTimer to start
+**      IntcPtr:     The interrupt controller, normally FreeRTOS'
+**                   xInterruptController
+**      IntrId:      Interrupt ID of the SCU private watchdog
+**
+**   Return Value:
+**      status: XST_SUCCESS, or the error of the interrupt controller driver
+**
+**   Description:
+**      Connect the timer interrupt and start counting. FreeRTOS initializes
+**      the interrupt controller when the scheduler starts, so this has to be
+**      called from a task.
+*/
+XStatus HWTIMER_start(HWTimer *InstancePtr, XScuGic *IntcPtr, u32 IntrId) {
+   XStatus status;
+   u32 control;
+
+   status = XScuGic_Connect(IntcPtr, IntrId,
+         (Xil_ExceptionHandler) HWTIMER_intrHandler, InstancePtr);
+   if (status != XST_SUCCESS)
+      return status;
+
+   control = XScuWdt_GetControlReg(&InstancePtr->wdt);
+   control |= XSCUWDT_CONTROL_AUTO_RELOAD_MASK | XSCUWDT_CONTROL_IT_ENABLE_MASK;
+   XScuWdt_SetControlReg(&InstancePtr->wdt, control);
+
+   XScuGic_Enable(IntcPtr, IntrId);
+   XScuWdt_Start(&InstancePtr->wdt);
+   return XST_SUCCESS;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void HWTIMER_stop(HWTimer *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A HWTimer to stop
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Stop the timer. Registered callbacks are kept.
+*/
+void HWTIMER_stop(HWTimer *InstancePtr) {
+   XScuWdt_Stop(&InstancePtr->wdt);
+}
+
+/* -------------------------------------------------------------------- */
+/*** void HWTIMER_tick(HWTimer *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A HWTimer to advance
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Advance the timebase by one tick and run every callback that is due.
+**      Called from the timer interrupt; it does not touch the hardware, so a
+**      host build can drive the same callbacks by calling it directly.
+*/
+void HWTIMER_tick(HWTimer *InstancePtr) {
+   u32 i;
+
+   InstancePtr->ticks++;
+   for (i = 0; i < InstancePtr->num_callbacks; i++) {
+      if (--InstancePtr->countdown[i] == 0) {
+         InstancePtr->countdown[i] = InstancePtr->divider[i];
+         InstancePtr->callback[i](InstancePtr->callback_ref[i]);
+      }
+   }
+}
+
+/* -------------------------------------------------------------------- */
+/*** static void HWTIMER_intrHandler(void *CallbackRef)
+**
+**   Parameters:
+**      CallbackRef: The HWTimer that raised the interrupt
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Acknowledge the timer event and run the tick.
+*/
+static void HWTIMER_intrHandler(void *CallbackRef) {
+   HWTimer *InstancePtr = (HWTimer *) CallbackRef;
+
+   XScuWdt_WriteReg(InstancePtr->wdt.Config.BaseAddr, XSCUWDT_ISR_OFFSET,
+         XSCUWDT_ISR_EVENT_FLAG_MASK);
+   HWTIMER_tick(InstancePtr);
+}
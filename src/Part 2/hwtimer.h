@@ -0,0 +1,47 @@
+#ifndef HWTIMER_H
+#define HWTIMER_H
+
+/****************************** Include Files ***************************/
+
+#include "xparameters.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xscugic.h"
+#include "xscuwdt.h"
+
+/************************** Constant Definitions ************************/
+
+#define HWTIMER_MAX_CALLBACKS 8
+
+// The SCU private timers count on CPU_3x2x, half the CPU clock
+#define HWTIMER_CLOCK_HZ (XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ / 2)
+
+/**************************** Type Definitions **************************/
+
+typedef void (*HWTIMER_Callback)(void *CallbackRef);
+
+// Periodic interrupt timebase shared by the drivers that need a fixed rate
+// tick. FreeRTOS owns the SCU private timer for its own tick, so this uses
+// the SCU private watchdog in timer mode. Every registered callback runs
+// from the interrupt every 'divider' ticks.
+typedef struct HWTimer {
+   XScuWdt wdt;
+   u32 rate_hz;
+   volatile u32 ticks;
+   u32 num_callbacks;
+   HWTIMER_Callback callback[HWTIMER_MAX_CALLBACKS];
+   void *callback_ref[HWTIMER_MAX_CALLBACKS];
+   u32 divider[HWTIMER_MAX_CALLBACKS];
+   u32 countdown[HWTIMER_MAX_CALLBACKS];
+} HWTimer;
+
+/************************** Function Definitions ************************/
+
+XStatus HWTIMER_begin(HWTimer *InstancePtr, u16 DeviceId, u32 rate_hz);
+XStatus HWTIMER_addCallback(HWTimer *InstancePtr, HWTIMER_Callback Callback,
+      void *CallbackRef, u32 divider);
+XStatus HWTIMER_start(HWTimer *InstancePtr, XScuGic *IntcPtr, u32 IntrId);
+void HWTIMER_stop(HWTimer *InstancePtr);
+void HWTIMER_tick(HWTimer *InstancePtr);
+
+#endif // HWTIMER_H
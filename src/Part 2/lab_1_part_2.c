@@ -30,9 +30,16 @@
 #include "xscugic.h"
 #include "xil_exception.h"
 #include "xil_printf.h"
+#include "xtime_l.h"
 
 //Other miscellaneous libraries
 #include "pmodkypd.h"
+#include "hwtimer.h"
+#include "shadowgpio.h"
+#include "pmodssd.h"
+#include "rgbpwm.h"
+#include "ledanim.h"
+#include "blink.h"
 #include "sleep.h"
 #include "xil_cache.h"
 #include "stdbool.h"
@@ -47,6 +54,8 @@
 #define LEDS_DEVICE_ID	XPAR_AXI_LEDS_DEVICE_ID
 #define BTN_DEVICE_ID	XPAR_AXI_GPIO_0_DEVICE_ID
 #define SW_DEVICE_ID	XPAR_AXI_GPIO_0_DEVICE_ID
+#define TIMER_DEVICE_ID	XPAR_SCUWDT_0_DEVICE_ID
+#define TIMER_INTR_ID	XPAR_SCUWDT_INTR
 
 // Device channels
 #define SSD_CHANNEL		1
@@ -67,28 +76,216 @@
 #define DEFAULT_KEYTABLE "0FED789C456B123A"
 
 // miscellaneous
-#define SSD_DELAY     17
+// SSD refresh calls per second. A digit slot takes SSD_BLANK_TICKS +
+// SSD_BRIGHTNESS_LEVELS calls of its display and the calls go to the
+// chained displays in turn, so with one display each digit is lit at
+// 4000 / (2 * (1 + 8)) = 222 Hz, free of flicker. Scale this with the
+// number of displays.
+#define SSD_REFRESH_HZ 4000
+// Refresh calls with the segments off before each digit switch, so the old
+// pattern does not ghost onto the new digit
+#define SSD_BLANK_TICKS 1
+// Command status messages scroll across the SSD at this many characters
+// per second, until the next key press
+#define SSD_MARQUEE_STEP_HZ 4
+#define SSD_MARQUEE_MAX_LEN 48
+
+// SSD refresh timing, dumped by the DF command: histogram buckets are
+// 2^SSD_JITTER_SHIFT global timer counts (about 1.5 us) wide, and every digit
+// must be refreshed at SSD_FLICKER_HZ or more to look steady
+#define SSD_JITTER_SHIFT 9
+#define SSD_FLICKER_HZ   60
+
+// Set to 1 to measure CPU utilisation, printed by the CC command. cpuLoadTask
+// counts loop iterations over windows of CPU_LOAD_WINDOW_MS and compares
+// them with the count of an idle CPU. It gets a priority of its own between
+// the idle task and the application tasks, which move up to make room, so
+// every other task preempts it and none shares its time slices. It keeps
+// the CPU busy and starves the idle task, so leave it off when not measuring.
+#define CPU_LOAD_MEASURE    0
+#define CPU_LOAD_WINDOW_MS  1000
+
+// Priority of the lowest application tasks
+#define TASK_PRIORITY_BASE  (tskIDLE_PRIORITY + 2 * CPU_LOAD_MEASURE)
+
+// Set to 1 to run RGBLedTask as a polling loop instead of blocking on its
+// queue: it checks the queue without waiting and rewrites the LED color on
+// every pass, sleeping only for half a blink period while the LED blinks.
+// The LED looks the same either way; the define exists so that CC can
+// measure the CPU load of both versions.
+#define RGB_LED_POLLING     0
+
+// Set to 1 to print the cost of SSD_refresh for 1 to SSD_MAX_DISPLAYS chained
+// displays at startup, timed over SSD_BENCHMARK_CALLS calls
+#define SSD_BENCHMARK       0
+#define SSD_BENCHMARK_CALLS 16384
+
+// Set to 1 to print the cost of RGBPWM_tick for a few colors at startup,
+// timed over RGBPWM_BENCHMARK_TICKS calls
+#define RGBPWM_BENCHMARK       0
+#define RGBPWM_BENCHMARK_TICKS 16384
+
+// Positions on the color wheel stepped through by the color commands
+#define RGB_HUES 16
+// Percentage of each blink period that the RGB LED is on
+#define RGB_BLINK_DUTY 50
+
+// LED animations: ticks per second of the animation engine, and the players
+// and tracks started by the EA, EB, E5, AC and A3 commands. At 1000 Hz the
+// key ticks are milliseconds.
+#define LED_ANIM_HZ        1000
+#define ANIM_PLAYER_RGB    0
+#define ANIM_PLAYER_GREEN  1
+#define ANIM_RGB_FADE      0
+#define ANIM_RGB_BREATHE   1
+#define ANIM_RGB_STROBE    2
+#define ANIM_RGB_TRACKS    3
+#define ANIM_GREEN_CHASE   0
+#define ANIM_GREEN_WALK    1
+#define ANIM_GREEN_TRACKS  2
+
+// Buttons are sampled by ButtonScanISR at this rate, so a BTN1 press stops
+// the green LED sequence on its rising edge however short it is
+#define BTN_SCAN_HZ 1000
 #define COMMAND_DELAY 50
 #define DELAY_500 	  500
 
+// keypad scanning: period of one scan and number of matching scans needed
+// before a key change is accepted. A change is accepted after
+// KYPD_SCAN_DELAY * KYPD_DEBOUNCE_SAMPLES ms when keypadTask scans, and after
+// 16 * KYPD_DEBOUNCE_SAMPLES steps of 1/KYPD_SCAN_HZ s (16 ms) when the
+// interrupt does, presses and releases alike.
+#define KYPD_SCAN_DELAY       5
+#define KYPD_DEBOUNCE_SAMPLES 4
+#define KYPD_EVENT_QUEUE_LEN  8
+
+// Set to 1 to scan the keypad from the hardware timer interrupt instead of
+// from keypadTask; keypadTask then only consumes the key events. The
+// interrupt advances the scan by one column pattern KYPD_SCAN_HZ times a
+// second.
+#define KYPD_SCAN_FROM_ISR    1
+#define KYPD_SCAN_HZ          4000
+
+// keypadTask notification bits: key events are ready, commandTask asks for
+// the command on the display to be cleared, RGBLedTask changed a setting
+// to be shown, or commandTask left a status message in xStatusQueue
+#define KEYPAD_NOTIFY_EVENTS  0x1
+#define KEYPAD_NOTIFY_RESET   0x2
+#define KEYPAD_NOTIFY_RGB     0x4
+#define KEYPAD_NOTIFY_STATUS  0x8
+#define KEYPAD_NOTIFY_ALL     0xF
+
+// hardware timebase shared by the interrupt driven drivers. The RGB LED PWM
+// runs at the full rate, so a PWM period of RGBPWM_PERIOD ticks lasts about
+// 8 ms (125 Hz); the other callbacks divide it down.
+#define TIMER_RATE_HZ 32000
+
 
 
 // Device declarations
 XGpio SSDInst, RGBInst, btnInst, swInst, greenLedsInst;
+// Output devices are written through shadows that skip unchanged writes
+ShadowGpio RGBOut, greenLedsOut;
+PmodSSD SSDDisplay;
+RGBPWM RGBLed;
+LEDANIM LedAnim;
+Blink RGBBlink;
 PmodKYPD KYPDInst;
+HWTimer TimerInst;
+
+// Interrupt controller instance owned by the FreeRTOS port
+extern XScuGic xInterruptController;
 
 // task declarations
 static void keypadTask   (void *pvParameters);
-static void sevenSegTask (void *pvParameters);
 static void commandTask  (void *pvParameters);
 static void RGBLedTask   (void *pvParameters);
 static void GreenLedTask (void *pvParameters);
+static void timerStartTask (void *pvParameters);
+#if CPU_LOAD_MEASURE
+static void cpuLoadTask    (void *pvParameters);
+#endif
 
 // queue declarations
-static QueueHandle_t xSSDQueue 	   = NULL;
 static QueueHandle_t xCommandQueue = NULL;
 static QueueHandle_t xRGBQueue 	   = NULL;
 static QueueHandle_t xLedQueue     = NULL;
+// mailbox holding the latest status message for keypadTask to scroll
+static QueueHandle_t xStatusQueue  = NULL;
+
+// keypad state shared with the timer interrupt
+static KYPD_Debouncer   xKeypadDebouncer;
+static KYPD_Event       xKeypadEventStorage[KYPD_EVENT_QUEUE_LEN];
+static KYPD_EventBuffer xKeypadEvents;
+static TaskHandle_t     xKeypadTask = NULL;
+
+// button state seen by the last ButtonScanISR
+static u32 xLastButtons;
+
+// status message scrolling on the SSD and its segment stream, both only
+// used by keypadTask
+static char xStatusText[SSD_MARQUEE_MAX_LEN];
+static u8 xStatusStream[SSD_MARQUEE_SIZE(SSD_MARQUEE_MAX_LEN)];
+
+// RGB LED setting last changed, for keypadTask to show: the message type
+// ('c' or 'f') in bits 24 and up and the new value in bits 0 to 23. Packed
+// into one word so it is read consistently.
+static volatile u32 xRGBStatus;
+
+// SSD refresh timing, updated by SSDRefreshISR. The DF command switches
+// the interrupt to the other buffer and reads the one it was filling.
+static SSD_Stats xSSDStats[2];
+
+#define ARRAY_LEN(array) (sizeof(array) / sizeof((array)[0]))
+
+// RGB LED blink frequencies stepped through by the EF command, in mHz. 0 is
+// steady; RGBPWMISR samples the blink at TIMER_RATE_HZ, so the fastest one
+// still gets 8 samples per period.
+static const u32 xRGBBlinkSteps[] = {
+	0, 500, 1000, 2000, 5000, 10000, 20000, 30000, 50000, 100000,
+	200000, 500000, 1000000, 2000000, 4000000,
+};
+
+// Half a blink period of the mHz frequency in RTOS ticks for the polling
+// RGBLedTask; 0 for periods shorter than two ticks, where it only yields
+#define RGB_POLL_BLINK_TICKS(mhz) pdMS_TO_TICKS(500000 / (mhz))
+
+// LED animation keyframes, compiled into the tracks at startup
+static const LEDANIM_Key xFadeKeys[] = {
+	{ 0xFF0000, 1500, LEDANIM_FADE },
+	{ 0x00FF00, 1500, LEDANIM_FADE },
+	{ 0x0000FF, 1500, LEDANIM_FADE },
+};
+static const LEDANIM_Key xBreatheKeys[] = {
+	{ 0x000000,  400, LEDANIM_STEP },
+	{ 0x000000, 1200, LEDANIM_FADE },
+	{ 0x0060FF, 1200, LEDANIM_FADE },
+};
+static const LEDANIM_Key xStrobeKeys[] = {
+	{ 0xFFFFFF,   30, LEDANIM_STEP },
+	{ 0x000000,  220, LEDANIM_STEP },
+};
+static const LEDANIM_Key xChaseKeys[] = {
+	{ 0x1, 150, LEDANIM_STEP },
+	{ 0x2, 150, LEDANIM_STEP },
+	{ 0x4, 150, LEDANIM_STEP },
+	{ 0x8, 150, LEDANIM_STEP },
+};
+static LEDANIM_Track xRGBTracks[ANIM_RGB_TRACKS];
+static const LEDANIM_Key xWalkKeys[] = {
+	{ 0x1, 500, LEDANIM_STEP },
+	{ 0x2, 500, LEDANIM_STEP },
+	{ 0x4, 500, LEDANIM_STEP },
+	{ 0x8, 500, LEDANIM_STEP },
+};
+static LEDANIM_Track xGreenTracks[ANIM_GREEN_TRACKS];
+
+#if CPU_LOAD_MEASURE
+// Idle loop count of one window with nothing else running, and the CPU
+// utilisation in percent over the last window
+static u32 xIdleCountMax;
+static volatile u32 xCPULoad;
+#endif
 
 // Message struct declaration
 // This will be used by the command handlers
@@ -100,7 +297,28 @@ typedef struct
 
 // Function prototypes
 void InitializeKeypad();
-u32 SSD_decode(u8 key_value, u8 cathode);
+static void KeypadScanISR(void *CallbackRef);
+static void SSDRefreshISR(void *CallbackRef);
+static void RGBPWMISR(void *CallbackRef);
+static void LedAnimISR(void *CallbackRef);
+static void ButtonScanISR(void *CallbackRef);
+static void AnimRGBOutput(void *OutputRef, u32 value);
+static void AnimGreenOutput(void *OutputRef, u32 value);
+static void ShowCommand(const char* command);
+static void ShowStatus(const char* text);
+static void PostStatus(const char* text);
+static u32 AppendText(char* text, u32 length, u32 size, const char* src);
+static u32 AppendDecimal(char* text, u32 length, u32 size, u32 value,
+		u32 digits);
+static void ShowRGBStatus(u32 status);
+static void PostRGBStatus(char type, u32 value);
+#if SSD_BENCHMARK
+static void SSDBenchmark(void);
+#endif
+#if RGBPWM_BENCHMARK
+static void RGBPWMBenchmark(void);
+#endif
+static void PrintChord(u16 keystate, u16 confidence);
 static void HandleECCommand(Message* message);
 static void HandleEFCommand(Message* message);
 static void HandleD5Command(Message* message);
@@ -108,8 +326,63 @@ static void HandleD4Command(Message* message);
 static void HandleE7Command(Message* message);
 static void HandleA5Command(Message* message);
 static void HandleA3Command(Message* message);
+static void HandleEACommand(Message* message);
+static void HandleEBCommand(Message* message);
+static void HandleE5Command(Message* message);
+static void HandleACCommand(Message* message);
+static void StartAnimation(Message* message, QueueHandle_t queue, u8 track,
+		const char* command, const char* text);
+static void HandleDBCommand(Message* message);
+static void HandleDFCommand(Message* message);
+#if CPU_LOAD_MEASURE
+static void HandleCCCommand(Message* message);
+static u32 CountIdleLoops(XTime end);
+#endif
+static void HandleListCommand(Message* message);
+static u32 CountsToNs(u32 counts);
 static void HandleUnknownCommand(const char* command);
 
+// Command registry. A two-key command is packed into a 16-bit code, first
+// key in the high byte. Each hex key maps to a nibble ('0'-'9' keep their
+// low 4 bits, 'A'-'F' gain 9 from bit 6), so the two nibbles index a dense
+// table of 256 slots built at compile time. Dispatch is one lookup and a
+// check of the stored code, which also rejects keys that are not hex
+// digits. Register a command by adding one COMMAND line to xCommands.
+typedef struct
+{
+	u16 code;
+	void (*handler)(Message* message);
+	const char* help;
+} Command;
+
+#define COMMAND_CODE(a, b)    ((u16) (((u8) (a) << 8) | (u8) (b)))
+#define COMMAND_NIBBLE(key)   ((((key) & 0xF) + ((key) >> 6) * 9) & 0xF)
+#define COMMAND_SLOT(code)    ((COMMAND_NIBBLE((code) >> 8) << 4) \
+                              | COMMAND_NIBBLE((code) & 0xFF))
+#define COMMAND_SLOTS         256
+#define COMMAND(a, b, handler, help) \
+	[COMMAND_SLOT(COMMAND_CODE(a, b))] = { COMMAND_CODE(a, b), handler, help }
+
+static const Command xCommands[COMMAND_SLOTS] = {
+	COMMAND('0', '0', HandleListCommand, "list commands"),
+	COMMAND('A', '3', HandleA3Command,   "green LEDs walk until BTN1"),
+	COMMAND('A', '5', HandleA5Command,   "green LEDs from switches"),
+	COMMAND('A', 'C', HandleACCommand,   "green LEDs chase"),
+#if CPU_LOAD_MEASURE
+	COMMAND('C', 'C', HandleCCCommand,   "CPU utilisation"),
+#endif
+	COMMAND('D', '4', HandleD4Command,   "rotate green LEDs"),
+	COMMAND('D', '5', HandleD5Command,   "shift green LEDs"),
+	COMMAND('D', 'B', HandleDBCommand,   "SSD brightness"),
+	COMMAND('D', 'F', HandleDFCommand,   "SSD refresh timing"),
+	COMMAND('E', '5', HandleE5Command,   "RGB LED strobe"),
+	COMMAND('E', '7', HandleE7Command,   "RGB LED on/off"),
+	COMMAND('E', 'A', HandleEACommand,   "RGB LED fade"),
+	COMMAND('E', 'B', HandleEBCommand,   "RGB LED breathe"),
+	COMMAND('E', 'C', HandleECCommand,   "RGB LED color"),
+	COMMAND('E', 'F', HandleEFCommand,   "RGB LED blink frequency"),
+};
+
 int main(void)
 {
 	int status;
@@ -160,53 +433,117 @@ int main(void)
 	XGpio_SetDataDirection(&btnInst, BTN_CHANNEL, 0x0F);
 	XGpio_SetDataDirection(&swInst, SW_CHANNEL, 0x0F);
 
+	SSD_begin(&SSDDisplay, &SSDInst, SSD_CHANNEL);
+	SSD_setBlanking(&SSDDisplay, SSD_BLANK_TICKS);
+	SSD_statsBegin(&SSDDisplay, &xSSDStats[1],
+			(u32) ((u64) COUNTS_PER_SECOND * (SSD_BLANK_TICKS + SSD_BRIGHTNESS_LEVELS)
+					* SSDDisplay.num_displays / SSD_REFRESH_HZ),
+			SSD_JITTER_SHIFT);
+	SSD_statsBegin(&SSDDisplay, &xSSDStats[0], xSSDStats[1].expected,
+			SSD_JITTER_SHIFT);
+#if SSD_BENCHMARK
+	SSDBenchmark();
+#endif
+	SGPIO_begin(&RGBOut, &RGBInst);
+	SGPIO_begin(&greenLedsOut, &greenLedsInst);
+	RGBPWM_begin(&RGBLed, &RGBOut, RGB_CHANNEL);
+	BLINK_begin(&RGBBlink, COUNTS_PER_SECOND);
+#if RGBPWM_BENCHMARK
+	RGBPWMBenchmark();
+#endif
+	LEDANIM_begin(&LedAnim);
+	LEDANIM_addPlayer(&LedAnim, AnimRGBOutput, &RGBLed);
+	LEDANIM_addPlayer(&LedAnim, AnimGreenOutput, &greenLedsOut);
+	LEDANIM_compile(&xRGBTracks[ANIM_RGB_FADE], xFadeKeys,
+			ARRAY_LEN(xFadeKeys), 1);
+	LEDANIM_compile(&xRGBTracks[ANIM_RGB_BREATHE], xBreatheKeys,
+			ARRAY_LEN(xBreatheKeys), 1);
+	LEDANIM_compile(&xRGBTracks[ANIM_RGB_STROBE], xStrobeKeys,
+			ARRAY_LEN(xStrobeKeys), 1);
+	LEDANIM_compile(&xGreenTracks[ANIM_GREEN_CHASE], xChaseKeys,
+			ARRAY_LEN(xChaseKeys), 1);
+	LEDANIM_compile(&xGreenTracks[ANIM_GREEN_WALK], xWalkKeys,
+			ARRAY_LEN(xWalkKeys), 1);
+
+	// Hardware timebase, started by timerStartTask once the scheduler runs
+	status = HWTIMER_begin(&TimerInst, TIMER_DEVICE_ID, TIMER_RATE_HZ);
+	if(status != XST_SUCCESS){
+		xil_printf("Hardware timer initialization failed.\r\n");
+		return XST_FAILURE;
+	}
+#if KYPD_SCAN_FROM_ISR
+	HWTIMER_addCallback(&TimerInst, KeypadScanISR, &KYPDInst,
+			TIMER_RATE_HZ / KYPD_SCAN_HZ);
+#endif
+	HWTIMER_addCallback(&TimerInst, SSDRefreshISR, &SSDDisplay,
+			TIMER_RATE_HZ / SSD_REFRESH_HZ);
+	HWTIMER_addCallback(&TimerInst, RGBPWMISR, &RGBLed, 1);
+	HWTIMER_addCallback(&TimerInst, LedAnimISR, &LedAnim,
+			TIMER_RATE_HZ / LED_ANIM_HZ);
+	HWTIMER_addCallback(&TimerInst, ButtonScanISR, &btnInst,
+			TIMER_RATE_HZ / BTN_SCAN_HZ);
+
 	/* Task creation */
     xTaskCreate( keypadTask,			  // The function that implements the task.
                 "main task", 			  // Text name for the task, provided to assist debugging only.
                 configMINIMAL_STACK_SIZE, // The stack allocated to the task.
                 NULL, 					  // The task parameter is not used, so set to NULL.
-                tskIDLE_PRIORITY,		  // The task runs at the idle priority.
-                NULL );                   // Optional task's handle
+                TASK_PRIORITY_BASE,	  // The task runs at the lowest application priority.
+                &xKeypadTask );           // Optional task's handle
 
-    xTaskCreate( sevenSegTask,
-				"SSD task",
-				configMINIMAL_STACK_SIZE,
-				NULL,
-				tskIDLE_PRIORITY,
-				NULL );
+    xTaskCreate( timerStartTask,
+                "timer start task",
+                configMINIMAL_STACK_SIZE,
+                NULL,
+                TASK_PRIORITY_BASE+2,
+                NULL );
 
     xTaskCreate( commandTask,
                 "command task",
                 configMINIMAL_STACK_SIZE,
                 NULL,
-                tskIDLE_PRIORITY+1,
+                TASK_PRIORITY_BASE+1,
                 NULL );
 
     xTaskCreate( RGBLedTask,
                 "RGB LED task",
                 configMINIMAL_STACK_SIZE,
                 NULL,
-                tskIDLE_PRIORITY,
+                TASK_PRIORITY_BASE,
                 NULL );
 
     xTaskCreate( GreenLedTask,
                 "green LEDs task",
                 configMINIMAL_STACK_SIZE,
                 NULL,
-                tskIDLE_PRIORITY,
+                TASK_PRIORITY_BASE,
                 NULL );
 
+#if CPU_LOAD_MEASURE
+    // Calibrate before anything else runs
+    XTime now;
+    XTime_GetTime(&now);
+    xIdleCountMax = CountIdleLoops(now + (u64) COUNTS_PER_SECOND * CPU_LOAD_WINDOW_MS / 1000);
+
+    xTaskCreate( cpuLoadTask,
+                "CPU load task",
+                configMINIMAL_STACK_SIZE,
+                NULL,
+                tskIDLE_PRIORITY+1,
+                NULL );
+#endif
+
     /* Queue creation */
-    xSSDQueue     = xQueueCreate(1, sizeof(char));
     xCommandQueue = xQueueCreate(1, sizeof(char[3]));
     xRGBQueue 	  = xQueueCreate(1, sizeof(Message));
     xLedQueue 	  = xQueueCreate(1, sizeof(Message));
+    xStatusQueue  = xQueueCreate(1, sizeof(xStatusText));
 
     // Assert queue creation
-    configASSERT(xSSDQueue);
     configASSERT(xCommandQueue);
 	configASSERT(xRGBQueue);
 	configASSERT(xLedQueue);
+	configASSERT(xStatusQueue);
 
     xil_printf(
         "\n====== App Ready ======\n"
@@ -227,129 +564,387 @@ void InitializeKeypad()
 {
    KYPD_begin(&KYPDInst, XPAR_AXI_KEYPAD_BASEADDR);
    KYPD_loadKeyTable(&KYPDInst, (u8*) DEFAULT_KEYTABLE);
+   KYPD_debounceInit(&xKeypadDebouncer, KYPD_DEBOUNCE_SAMPLES);
+   KYPD_eventBufferInit(&xKeypadEvents, xKeypadEventStorage, KYPD_EVENT_QUEUE_LEN);
 }
 
-// This function translates key value codes to their binary representation
-u32 SSD_decode(u8 key_value, u8 cathode)
-{
-    u32 result;
-
-    // key_value is the ASCII code of the pressed key
-	// The switch statement maps each ASCII code to the corresponding
-	// 7-segment display encoding. The 7-segment display encoding is
-	// represented as a binary number where each bit corresponds to a segment.
-	// A bit value of 1 means the segment is on, and 0 means it's off.
-    switch(key_value){
-        case 48: result = 0b00111111; break; // 0
-        case 49: result = 0b00110000; break; // 1
-        case 50: result = 0b01011011; break; // 2
-        case 51: result = 0b01111001; break; // 3
-        case 52: result = 0b01110100; break; // 4
-        case 53: result = 0b01101101; break; // 5
-        case 54: result = 0b01101111; break; // 6
-        case 55: result = 0b00111000; break; // 7
-        case 56: result = 0b01111111; break; // 8
-        case 57: result = 0b01111100; break; // 9
-        case 65: result = 0b01111110; break; // A
-        case 66: result = 0b01100111; break; // B
-        case 67: result = 0b00001111; break; // C
-        case 68: result = 0b01110011; break; // D
-        case 69: result = 0b01001111; break; // E
-        case 70: result = 0b01001110; break; // F
-        default: result = 0b00000000; break; // Undefined, all segments are OFF
-    }
+// Hardware timer callback: advances the keypad scan by one column pattern
+// and, whenever a full keystate is available, debounces it and wakes
+// keypadTask if that produced key events. Runs in interrupt context.
+static void KeypadScanISR(void *CallbackRef)
+{
+   PmodKYPD *InstancePtr = (PmodKYPD*) CallbackRef;
+   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+   u16 keystate;
 
-    // cathode determines which of the two 7-segment displays is active.
-	// - A cathode value of 1 activates the right display
-	// - A cathode value of 0 activates the left display
-	// The Most Significant Bit (MSB) is used as the control bit to select the display.
-	// The MSB is set to 1 for the right display and left as 0 for the left display.
-    if(cathode==0){
-    	return result; // MSB is 0, left display active
-    }
-    else {
-    	return result | 0b10000000; // MSB is set to 1, right display active
-    }
+   if(!KYPD_scanStep(InstancePtr, &keystate)){
+      return;
+   }
+   keystate = KYPD_debounce(&xKeypadDebouncer, keystate);
+   if(KYPD_pollEvents(InstancePtr, keystate, TimerInst.ticks, &xKeypadEvents) > 0){
+      xTaskNotifyFromISR(xKeypadTask, KEYPAD_NOTIFY_EVENTS, eSetBits,
+            &xHigherPriorityTaskWoken);
+   }
+   portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
-
 /**
- * This task is responsible for continuously monitoring the state of a keypad
- * and sending the detected key presses to a queue for further processing.
+ * This task is responsible for continuously monitoring the state of a keypad,
+ * building the two-key command from the detected key presses and showing it
+ * on the seven-segment display (SSD). It is the only task writing the SSD
+ * frame; commandTask clears the command through a task notification, so a
+ * reset can no longer be lost to a key press arriving at the same time.
+ * Key edges come from the driver's event stream, so no last-state
+ * bookkeeping is needed here.
  **/
 static void keypadTask( void *pvParameters )
 {
-   u16 keystate;
-   XStatus status, last_status = KYPD_NO_KEY;
-   u8 new_key='0';
+   KYPD_Event event;
+   char command[3] = {'x', 'x', '\0'}; // Array to hold the command for the command task
+   uint32_t notified;
+   bool changed;
 
    while (1){
-	  // Reading the keypad state
-	  keystate = KYPD_getKeyStates(&KYPDInst);
-	  status = KYPD_getKeyPressed(&KYPDInst, keystate, &new_key);
-
-	  // Sending key presses using the queue
-	  if(status == KYPD_SINGLE_KEY && last_status == KYPD_NO_KEY){
-		  xQueueOverwrite(xSSDQueue, &new_key);
-	  } else if (status == KYPD_MULTI_KEY && status != last_status){
-		  xil_printf("Error: Multiple keys pressed\r\n");
+	  notified = 0;
+#if KYPD_SCAN_FROM_ISR
+	  // Wait for KeypadScanISR to report key events or commandTask to reset
+	  xTaskNotifyWait(0, KEYPAD_NOTIFY_ALL, &notified, portMAX_DELAY);
+#else
+	  // Wait one scan period, or less if commandTask resets the command
+	  xTaskNotifyWait(0, KEYPAD_NOTIFY_ALL, &notified, pdMS_TO_TICKS(KYPD_SCAN_DELAY));
+
+	  // Reading and debouncing the keypad state
+	  u16 keystate = KYPD_getKeyStates(&KYPDInst);
+	  keystate = KYPD_debounce(&xKeypadDebouncer, keystate);
+	  KYPD_pollEvents(&KYPDInst, keystate, xTaskGetTickCount(), &xKeypadEvents);
+#endif
+
+	  if(notified & KEYPAD_NOTIFY_RGB){
+		  ShowRGBStatus(xRGBStatus);
+	  }
+	  if((notified & KEYPAD_NOTIFY_STATUS)
+			  && xQueueReceive(xStatusQueue, xStatusText, 0) == pdPASS){
+		  ShowStatus(xStatusText);
+	  }
+
+	  changed = false;
+	  if(notified & KEYPAD_NOTIFY_RESET){
+		  command[0] = 'x';
+		  command[1] = 'x';
+		  changed = true;
+	  }
+
+	  // Shifting single key presses into the command
+	  while(KYPD_readEvent(&xKeypadEvents, &event)){
+		  if(event.type != KYPD_EVENT_PRESS){
+			  continue;
+		  }
+		  if(event.keystate == (1 << event.key)){
+			  SSD_marqueeStop(&SSDDisplay);
+			  command[0] = command[1];
+			  command[1] = event.ch;
+			  changed = true;
+		  } else {
+			  PrintChord(event.keystate, KYPDInst.confidence);
+		  }
+	  }
+
+	  if(changed){
+		  // Send the command to the command task queue and display it
+		  xQueueOverwrite(xCommandQueue, &command);
+		  ShowCommand(command);
 	  }
+   }
+}
 
-	  // updating last_status
-      last_status = status;
 
-      // Delay to throttle the loop
-      vTaskDelay(pdMS_TO_TICKS(COMMAND_DELAY));
+// Prints the keys of a multi-key press; keys the decoder could not tell
+// apart from a ghost are listed after a '?'.
+static void PrintChord(u16 keystate, u16 confidence)
+{
+   u8 keys[16];
+   u32 count, i;
+
+   count = KYPD_getKeysPressed(&KYPDInst, keystate, keys);
+   xil_printf("Keys pressed:");
+   for(i = 0; i < count; i++){
+      xil_printf(" %c", keys[i]);
+   }
+   if(confidence != 0xFFFF){
+      count = KYPD_getKeysPressed(&KYPDInst, ~confidence, keys);
+      xil_printf(" (?");
+      for(i = 0; i < count; i++){
+         xil_printf(" %c", keys[i]);
+      }
+      xil_printf(")");
    }
+   xil_printf("\r\n");
 }
 
 
 /**
- * This task is responsible for displaying characters on a seven-segment display (SSD)
- * based on key presses received from a queue and sending them to another command task.
+ * Connects the hardware timer interrupt once the scheduler is running (the
+ * FreeRTOS port sets up the interrupt controller when the scheduler starts)
+ * and then deletes itself.
  */
-static void sevenSegTask( void *pvParameters )
+static void timerStartTask( void *pvParameters )
 {
-    u8 current_key = 'x';
-    u32 ssd_value = 0; // Value to be displayed on the SSD
-    char command[3] = {'x', 'x', '\0'}; // Array to hold the command for the command task
+	if(HWTIMER_start(&TimerInst, &xInterruptController, TIMER_INTR_ID) != XST_SUCCESS){
+		xil_printf("Hardware timer start failed.\r\n");
+	}
+	vTaskDelete(NULL);
+}
 
-    while(1){
-        // Attempt to receive a key press from the queue
-        if(xQueueReceive(xSSDQueue, &current_key, 0) == pdTRUE){
-            if(current_key == 'r') {
-                // If 'r' is received, reset the current and previous keys
-                command[0] = 'x';
-                command[1] = 'x';
-            } else {
-                // Update the command for the command task
-                command[0] = command[1];
-                command[1] = current_key;
-            }
 
-            // Send the command to the command task queue
-            xQueueOverwrite(xCommandQueue, &command);
+// Shows the current key on the right digit and the previous key on the
+// left. Both digits go into the back buffer and are published together,
+// so SSDRefreshISR never shows half of an update.
+static void ShowCommand(const char* command)
+{
+   SSD_setDigit(&SSDDisplay, SSD_DIGIT_RIGHT, SSD_decode(command[1], 0));
+   SSD_setDigit(&SSDDisplay, SSD_DIGIT_LEFT, SSD_decode(command[0], 0));
+   SSD_swap(&SSDDisplay);
+}
 
-        }
 
-        // Display the current key on the SSD
-		ssd_value = SSD_decode(command[1], 1);
-		XGpio_DiscreteWrite(&SSDInst, SSD_CHANNEL, ssd_value);
-		vTaskDelay(pdMS_TO_TICKS(SSD_DELAY)); // Delay for persistence of vision
+// Scrolls a status message across the SSD in place of the command. The
+// message is decoded once here; SSDRefreshISR only indexes the stream.
+// Only keypadTask, which owns the SSD, calls this; other tasks use
+// PostStatus.
+static void ShowStatus(const char* text)
+{
+   u32 length;
+
+   SSD_marqueeStop(&SSDDisplay);
+   length = SSD_marqueeCompile(&SSDDisplay, text, xStatusStream, sizeof(xStatusStream));
+   if(length != 0){
+      SSD_marqueeStart(&SSDDisplay, xStatusStream, length,
+            SSD_REFRESH_HZ / (SSDDisplay.num_digits
+                  * (SSD_BLANK_TICKS + SSD_BRIGHTNESS_LEVELS) * SSD_MARQUEE_STEP_HZ));
+   }
+}
 
-		// Display the previous key (now the current key after shifting) on the SSD
-        ssd_value = SSD_decode(command[0], 0);
-        XGpio_DiscreteWrite(&SSDInst, SSD_CHANNEL, ssd_value);
-        vTaskDelay(pdMS_TO_TICKS(SSD_DELAY)); // Delay for persistence of vision
-    }
+
+// Shows an RGB LED setting in place of the command: 'c' and the color,
+// which stays until the command changes, or the achieved blink frequency,
+// which scrolls until the next key press.
+static void ShowRGBStatus(u32 status)
+{
+   u32 value = status & 0xFFFFFF;
+   char text[24];
+   u32 length;
+
+   if((status >> 24) == 'c'){
+      SSD_marqueeStop(&SSDDisplay);
+      SSD_setDigit(&SSDDisplay, 0, SSD_decode('c', 0));
+      SSD_setNumber(&SSDDisplay, 1, SSDDisplay.num_digits - 1, value,
+            SSD_BASE_HEX, 0);
+      SSD_swap(&SSDDisplay);
+   } else if(value == 0){
+      ShowStatus("no blink");
+   } else {
+      length = AppendDecimal(text, 0, sizeof(text), value / 1000, 1);
+      length = AppendText(text, length, sizeof(text), ".");
+      length = AppendDecimal(text, length, sizeof(text), value % 1000, 3);
+      AppendText(text, length, sizeof(text), " Hz");
+      ShowStatus(text);
+   }
+}
+
+
+// Hands a status message to keypadTask, which owns the SSD. The mailbox
+// keeps only the latest message, copied here so text may be reused at once.
+static void PostStatus(const char* text)
+{
+   char message[SSD_MARQUEE_MAX_LEN];
+
+   AppendText(message, 0, sizeof(message), text);
+   xQueueOverwrite(xStatusQueue, message);
+   xTaskNotify(xKeypadTask, KEYPAD_NOTIFY_STATUS, eSetBits);
+}
+
+
+// Appends src to the string of length characters in text, a buffer of
+// size bytes, cutting it short if it does not fit. Returns the new length.
+static u32 AppendText(char* text, u32 length, u32 size, const char* src)
+{
+   while(*src != '\0' && length + 1 < size){
+      text[length++] = *src++;
+   }
+   text[length] = '\0';
+   return length;
+}
+
+
+// Appends value in decimal with at least digits digits, zero padded, in
+// the same way as AppendText. Returns the new length.
+static u32 AppendDecimal(char* text, u32 length, u32 size, u32 value,
+		u32 digits)
+{
+   char reversed[10];
+   u32 count = 0;
+
+   do {
+      reversed[count++] = '0' + value % 10;
+      value /= 10;
+   } while((value != 0 || count < digits) && count < sizeof(reversed));
+
+   while(count > 0 && length + 1 < size){
+      text[length++] = reversed[--count];
+   }
+   text[length] = '\0';
+   return length;
+}
+
+
+// Hands a changed RGB LED setting to keypadTask, which owns the SSD
+static void PostRGBStatus(char type, u32 value)
+{
+   xRGBStatus = ((u32) type << 24) | (value & 0xFFFFFF);
+   xTaskNotify(xKeypadTask, KEYPAD_NOTIFY_RGB, eSetBits);
+}
+
+
+// Converts global timer counts to nanoseconds
+static u32 CountsToNs(u32 counts)
+{
+   return (u32) ((u64) counts * 1000000000ULL / COUNTS_PER_SECOND);
+}
+
+
+#if SSD_BENCHMARK
+// Times SSD_refresh for every chain length. All displays of the test chains
+// are mapped onto the one SSD, so the time includes the real AXI GPIO write.
+// The cost per call should not grow with the number of digits.
+static void SSDBenchmark(void)
+{
+   PmodSSD bench;
+   XTime start, end;
+   u32 displays, i;
+
+   for(displays = 1; displays <= SSD_MAX_DISPLAYS; displays++){
+      SSD_begin(&bench, &SSDInst, SSD_CHANNEL);
+      for(i = 1; i < displays; i++){
+         SSD_addDisplay(&bench, &SSDInst, SSD_CHANNEL);
+      }
+
+      XTime_GetTime(&start);
+      for(i = 0; i < SSD_BENCHMARK_CALLS; i++){
+         SSD_refresh(&bench);
+      }
+      XTime_GetTime(&end);
+
+      xil_printf("SSD refresh, %d digits: %d ns per call\r\n", bench.num_digits,
+            CountsToNs((u32) (end - start)) / SSD_BENCHMARK_CALLS);
+   }
+}
+#endif
+
+
+// Hardware timer callback: lights the next SSD digit. Runs in interrupt
+// context.
+static void SSDRefreshISR(void *CallbackRef)
+{
+   SSD_refresh((PmodSSD*) CallbackRef);
+}
+
+
+#if RGBPWM_BENCHMARK
+// Times RGBPWM_tick on the real RGB LED for colors with no, one, two and
+// three distinct transitions per period. The cost per tick should be the
+// same for all of them.
+static void RGBPWMBenchmark(void)
+{
+   static const u32 colors[] = {0x000000, 0xFFFFFF, 0x808080, 0x204080,
+         0x102040};
+   RGBPWM bench;
+   XTime start, end;
+   u32 c, i;
+
+   for(c = 0; c < sizeof(colors) / sizeof(colors[0]); c++){
+      RGBPWM_begin(&bench, &RGBOut, RGB_CHANNEL);
+      RGBPWM_setColor(&bench, colors[c]);
+
+      XTime_GetTime(&start);
+      for(i = 0; i < RGBPWM_BENCHMARK_TICKS; i++){
+         RGBPWM_tick(&bench);
+      }
+      XTime_GetTime(&end);
+
+      xil_printf("RGB PWM tick, color %06x: %d ns, %d CPU cycles per tick\r\n",
+            colors[c], CountsToNs((u32) (end - start)) / RGBPWM_BENCHMARK_TICKS,
+            (u32) ((end - start) * XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ /
+                  COUNTS_PER_SECOND / RGBPWM_BENCHMARK_TICKS));
+   }
+   SGPIO_write(&RGBOut, RGB_CHANNEL, 0);
+}
+#endif
+
+
+// Hardware timer callback: advances the RGB LED PWM by one tick, gated by
+// the blink. The blink is timed by the free-running global timer, so its
+// edges do not depend on when this interrupt runs. Runs in interrupt
+// context.
+static void RGBPWMISR(void *CallbackRef)
+{
+   XTime now;
+
+   XTime_GetTime(&now);
+   RGBPWM_setGate((RGBPWM*) CallbackRef, BLINK_sample(&RGBBlink, now));
+   RGBPWM_tick((RGBPWM*) CallbackRef);
+}
+
+
+// Hardware timer callback: advances the LED animations by one tick. Runs in
+// interrupt context.
+static void LedAnimISR(void *CallbackRef)
+{
+   LEDANIM_tick((LEDANIM*) CallbackRef);
+}
+
+
+// Animation outputs, called from LedAnimISR while a track plays. The LED
+// tasks stop their player before writing the LEDs themselves, so the RGB
+// LED color is only set by LedAnimISR while an animation plays and only by
+// RGBLedTask otherwise.
+static void AnimRGBOutput(void *OutputRef, u32 value)
+{
+   RGBPWM_setColor((RGBPWM*) OutputRef, value);
+}
+
+static void AnimGreenOutput(void *OutputRef, u32 value)
+{
+   SGPIO_write((ShadowGpio*) OutputRef, LEDS_CHANNEL, value);
+}
+
+
+// Hardware timer callback: stops the green LED sequence on each rising edge
+// of BTN1 while one is playing or about to start, and asks GreenLedTask to
+// show its own value again. The stop itself cannot be lost. If the queue is
+// full the message is dropped, which is harmless: GreenLedTask runs for the
+// queued messages, and every one of them takes the LEDs back or starts a
+// newer sequence. Runs in interrupt context.
+static void ButtonScanISR(void *CallbackRef)
+{
+   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+   Message message = {.type = 'h', .action = 'x'};
+   u32 buttons = XGpio_DiscreteRead((XGpio*) CallbackRef, BTN_CHANNEL);
+
+   if((buttons & ~xLastButtons & BTN1)
+         && LEDANIM_stopFromISR(&LedAnim, ANIM_PLAYER_GREEN)){
+      (void) xQueueSendFromISR(xLedQueue, &message, &xHigherPriorityTaskWoken);
+   }
+   xLastButtons = buttons;
+   portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 
 static void commandTask( void *pvParameters )
 {
 	char command[3] = {'x', 'x', '\0'};
-	const char RESET_CHAR = 'r';
 	unsigned int buttonVal=0, lastButtonVal=0;
 	Message message = {.type = 'x', .action = 'x'};
+	const Command* entry;
+	u16 code;
 
 	while(1){
 
@@ -357,28 +952,15 @@ static void commandTask( void *pvParameters )
         buttonVal = XGpio_DiscreteRead(&btnInst, 1);
 
         if(lastButtonVal == 0 && buttonVal == BTN0){
-            if(strcmp(command, "E7") == 0){
-            	HandleE7Command(&message);
-            } else if(strcmp(command, "EC") == 0){
-            	HandleECCommand(&message);
-            } else if(strcmp(command, "EF") == 0){
-            	HandleEFCommand(&message);
-			} else if(strcmp(command, "A5") == 0){
-				HandleA5Command(&message);
-            } else if(strcmp(command, "D5") == 0){
-            	HandleD5Command(&message);
-            } else if(strcmp(command, "D4") == 0){
-				HandleD4Command(&message);
-            } else if(strcmp(command, "A3") == 0){
-/*************************** Enter your code here ****************************/
-			// TODO: Implement handling for the command "A3".
-            	HandleA3Command(&message);
-/*****************************************************************************/
+            code = COMMAND_CODE(command[0], command[1]);
+            entry = &xCommands[COMMAND_SLOT(code)];
+            if(entry->handler != NULL && entry->code == code){
+            	entry->handler(&message);
             } else {
             	HandleUnknownCommand(command);
             }
 
-            xQueueOverwrite(xSSDQueue, &RESET_CHAR);
+            xTaskNotify(xKeypadTask, KEYPAD_NOTIFY_RESET, eSetBits);
             vTaskDelay(pdMS_TO_TICKS(DELAY_500)); // Delay after finish
         }
 
@@ -397,12 +979,25 @@ static void GreenLedTask( void *pvParameters )
 	while(1){
 		xQueueReceive(xLedQueue, &message, portMAX_DELAY);
 
+		// Any message ends an animation, which leaves the LEDs to this task
+		LEDANIM_stop(&LedAnim, ANIM_PLAYER_GREEN);
+
 		// Update green LEDs values
 
 		xil_printf("message.type = %C\n", message.type);
 		xil_printf("message.action = %C\n", message.action);
 
 		switch(message.type){
+            case 'p': // play an animation until the next message
+                if((u8) (message.action - '0') < ANIM_GREEN_TRACKS){
+                    LEDANIM_play(&LedAnim, ANIM_PLAYER_GREEN,
+                            &xGreenTracks[message.action - '0']);
+                }
+                continue;
+
+            case 'h': // BTN1 pressed: the sequence is stopped, show the value
+                break;
+
             case 'a': // set the green LEDs to the values of the switches
 /*************************** Enter your code here ****************************/
 				// TODO: Assign the value read from 'swInst' to the variable
@@ -437,34 +1032,73 @@ static void GreenLedTask( void *pvParameters )
                 break;
         }
 		// Write new green LEDs values
-   		XGpio_DiscreteWrite(&greenLedsInst, 1, greenLedsValue);
+   		SGPIO_write(&greenLedsOut, LEDS_CHANNEL, greenLedsValue);
 	}
 }
 
 
+/**
+ * Applies RGB LED messages. The task blocks on its queue and only runs when
+ * a message arrives: a steady color is handed to the PWM engine once,
+ * and blinking and animations are left to the timer interrupt, so nothing
+ * is spent here while the LED does not change. With RGB_LED_POLLING set it
+ * polls the queue instead and keeps rewriting the color in between.
+ */
 static void RGBLedTask( void *pvParameters )
 {
 	// Define a structure to hold the state of the RGB LED.
 	typedef struct
 	{
-		u8 color:3;   // 3-bit color value representing RGB
-		u8 frequency; // Blink frequency of the LED
+		u8 color;     // Position on the color wheel, 0 to RGB_HUES - 1
+		u8 frequency; // Blink frequency of the LED, index into xRGBBlinkSteps
 		bool state;   // State of the LED: ON or OFF
 	} RGBLedState;
 
-	TickType_t xLastWakeTime, blinkDelayTicks = 0;
-	xLastWakeTime = xTaskGetTickCount(); // Initialize with the current tick count
+	u32 achieved;
+	u32 color = 0;
+#if RGB_LED_POLLING
+	bool animating = false;
+#endif
 
 	// Set initial LED state
-	RGBLedState RGBState = { .color = 1, .frequency = 0, .state = false };
+	RGBLedState RGBState = { .color = 0, .frequency = 0, .state = false };
 	Message message = {.type = 'x', .action = 'x'};
 
-
 	while(1)
 	{
-		// Handle incoming messages to change LED state
+#if RGB_LED_POLLING
+		// Rewrite the color until a message arrives. LedAnimISR owns the
+		// color while an animation plays, and the blink gate still comes
+		// from the timer interrupt, so only the task's own cost changes.
+		while(xQueueReceive(xRGBQueue, &message, 0) == pdFALSE){
+			if(!animating){
+				configASSERT(!LEDANIM_isPlaying(&LedAnim, ANIM_PLAYER_RGB));
+				RGBPWM_setColor(&RGBLed, color);
+			}
+			if(RGBState.state && RGBState.frequency != 0){
+				vTaskDelay(RGB_POLL_BLINK_TICKS(xRGBBlinkSteps[RGBState.frequency]));
+			}
+		}
+		animating = (message.type == 'p');
+#else
+		// Wait for a message to change the LED state
+		xQueueReceive(xRGBQueue, &message, portMAX_DELAY);
+#endif
+
+		// Any message ends an animation, which leaves the LED to this task
+		LEDANIM_stop(&LedAnim, ANIM_PLAYER_RGB);
+
 		switch(message.type){
 
+            case 'p': // Play an animation until the next message
+                RGBState.frequency = 0;
+                BLINK_setFrequency(&RGBBlink, 0, RGB_BLINK_DUTY);
+                if((u8) (message.action - '0') < ANIM_RGB_TRACKS){
+                    LEDANIM_play(&LedAnim, ANIM_PLAYER_RGB,
+                            &xRGBTracks[message.action - '0']);
+                }
+                continue;
+
             case 't': // Toggle LED state
                 RGBState.state = !RGBState.state;
                 break;
@@ -476,21 +1110,19 @@ static void RGBLedTask( void *pvParameters )
 				// TODO: Update the RGB LED color depending on the value of
 				// 'message.action'
                 if (message.action == '+') {
-                    RGBState.color += 1;
+                    RGBState.color = (RGBState.color + 1) % RGB_HUES;
                 } else if (message.action == '-') {
-                	RGBState.color -= 1;
+                	RGBState.color = (RGBState.color + RGB_HUES - 1) % RGB_HUES;
                 }
 /*****************************************************************************/
-                if (RGBState.color != 0) {
-                	xil_printf("color: %d\n", RGBState.color);
-                }
+                PostRGBStatus('c', RGBState.color);
 
                 break;
 
             case 'f': // Adjust LED blink frequency
                 RGBState.state = true;
                 if(message.action=='+'){
-                    if(RGBState.frequency < 30){
+                    if(RGBState.frequency < ARRAY_LEN(xRGBBlinkSteps) - 1){
                         RGBState.frequency++;
                     } else {
                     	RGBState.frequency = 0;
@@ -499,43 +1131,72 @@ static void RGBLedTask( void *pvParameters )
                     if(RGBState.frequency > 0){
                         RGBState.frequency--;
                     } else {
-                    	RGBState.frequency = 30;
+                    	RGBState.frequency = ARRAY_LEN(xRGBBlinkSteps) - 1;
                     }
                 }
-                // Calculate the delay in ticks after the frequency has been updated
-				if (RGBState.frequency != 0) {
-					blinkDelayTicks = pdMS_TO_TICKS(1000 / (2 * RGBState.frequency));
-				} else {
-					// If the frequency is 0, we set the delay to a default value,
-					blinkDelayTicks = portMAX_DELAY; // This will stop the blinking
-				}
-                xil_printf("frequency: %d\n", RGBState.frequency);
+                // The blink period is rounded to global timer counts, so
+                // report the frequency that really results
+                achieved = BLINK_setFrequency(&RGBBlink,
+                        xRGBBlinkSteps[RGBState.frequency], RGB_BLINK_DUTY);
+                xil_printf("blink %d.%03d Hz, %d.%03d Hz asked\n",
+                        achieved / 1000, achieved % 1000,
+                        xRGBBlinkSteps[RGBState.frequency] / 1000,
+                        xRGBBlinkSteps[RGBState.frequency] % 1000);
+                PostRGBStatus('f', achieved);
                 break;
             default:
                     break;
 		}
 
-		// Loop to process LED control until a new message is received
-		while (xQueueReceive(xRGBQueue, &message, 0) == pdFALSE){
-			if(RGBState.state){
-			    if (RGBState.frequency == 0){
-			        // If frequency is 0, write the color without blinking.
-			        XGpio_DiscreteWrite(&RGBInst, RGB_CHANNEL, RGBState.color);
-			    } else { // Blink the LED on and off according to the specified frequency
-			        XGpio_DiscreteWrite(&RGBInst, RGB_CHANNEL, RGBState.color);
-			        vTaskDelayUntil(&xLastWakeTime, blinkDelayTicks);
-			        XGpio_DiscreteWrite(&RGBInst, RGB_CHANNEL, 0);
-			        vTaskDelayUntil(&xLastWakeTime, blinkDelayTicks);
-			    }
-			} else {
-			    // Turn off the LED if the state is false
-			    XGpio_DiscreteWrite(&RGBInst, RGB_CHANNEL, 0);
-			}
+		if(RGBState.state){
+			color = RGBPWM_hue(RGBState.color * (RGBPWM_HUE_RANGE / RGB_HUES));
+		} else {
+		    // Turn off the LED if the state is false
+		    color = 0;
 		}
+		// LedAnimISR must not be setting the color as well
+		configASSERT(!LEDANIM_isPlaying(&LedAnim, ANIM_PLAYER_RGB));
+		RGBPWM_setColor(&RGBLed, color);
 	}
 }
 
 
+#if CPU_LOAD_MEASURE
+/**
+ * Counts idle loops below every other task for one window after another and
+ * turns each count into the CPU utilisation of that window: the fewer loops
+ * it gets to run, the more time the other tasks and interrupts took.
+ */
+static void cpuLoadTask( void *pvParameters )
+{
+	XTime windowEnd;
+	u32 count;
+
+	XTime_GetTime(&windowEnd);
+	while(1){
+		windowEnd += (u64) COUNTS_PER_SECOND * CPU_LOAD_WINDOW_MS / 1000;
+		count = CountIdleLoops(windowEnd);
+		xCPULoad = count >= xIdleCountMax ? 0 : 100 - (u32) ((u64) count * 100 / xIdleCountMax);
+	}
+}
+
+
+// Spins until the global timer reaches end and returns the number of loops.
+// Used both for calibration and by cpuLoadTask, so the counts compare.
+static u32 CountIdleLoops(XTime end)
+{
+	XTime now;
+	u32 count = 0;
+
+	do {
+		count++;
+		XTime_GetTime(&now);
+	} while(now < end);
+	return count;
+}
+#endif
+
+
 /****************************************
  *These are the command handler functions
  ****************************************/
@@ -544,6 +1205,7 @@ static void HandleE7Command(Message* message)
     message->type = 't';
     xQueueSend(xRGBQueue, message, 0);
     xil_printf("\n----------E7----------\nRGB LED state changed\n");
+    PostStatus("RGB LED state changed");
     xil_printf("-------Finished-------\n");
 }
 
@@ -625,6 +1287,7 @@ static void HandleA5Command(Message* message)
     message->type = 'a';
     xQueueSend(xLedQueue, message, 0);
     xil_printf("\n----------A5----------\ngreen LEDs values set\n");
+    PostStatus("green LEDs values set");
     xil_printf("-------Finished-------\n");
 }
 
@@ -704,33 +1367,197 @@ static void HandleD4Command(Message* message)
 static void HandleA3Command(Message* message)
 {
 /*************************** Enter your code here ****************************/
-	// TODO:
-	unsigned int buttonVal = 0;
-	    const TickType_t xDelay = 500 / portTICK_PERIOD_MS;
+	// Walk one lit LED across the green LEDs until BTN1 is pressed.
+	// GreenLedTask plays the sequence, so commandTask is free right away.
+	StartAnimation(message, xLedQueue, ANIM_GREEN_WALK, "A3",
+			"green LEDs walk, BTN1 stops");
+/*****************************************************************************/
+}
 
-	    u8 greenLedsValue = 1;
 
-	    while (1) {
-	        XGpio_DiscreteWrite(&greenLedsInst, LEDS_CHANNEL, greenLedsValue);
+// Starts an LED animation with a single message to the task owning the LEDs.
+// The animation runs until the next command for those LEDs.
+static void StartAnimation(Message* message, QueueHandle_t queue, u8 track,
+		const char* command, const char* text)
+{
+    message->type = 'p';
+    message->action = '0' + track;
+    xQueueSend(queue, message, 0);
+    xil_printf("\n----------%s----------\n%s\n", command, text);
+    PostStatus(text);
+    xil_printf("-------Finished-------\n");
+}
 
-	        greenLedsValue = greenLedsValue << 1;
 
-	        if (greenLedsValue > 8) {
-	            greenLedsValue = 1;
-	        }
+static void HandleEACommand(Message* message)
+{
+    StartAnimation(message, xRGBQueue, ANIM_RGB_FADE, "EA", "RGB LED fade");
+}
 
-	        buttonVal = XGpio_DiscreteRead(&btnInst, BTN_CHANNEL);
-	        if (buttonVal & BTN1) {
-	            xil_printf("btn1 pressed, exiting A3 command handler\n");
-	            break;
-	        }
 
-	        vTaskDelay(xDelay);
-	    }
-/*****************************************************************************/
+static void HandleEBCommand(Message* message)
+{
+    StartAnimation(message, xRGBQueue, ANIM_RGB_BREATHE, "EB",
+            "RGB LED breathe");
+}
+
+
+static void HandleE5Command(Message* message)
+{
+    StartAnimation(message, xRGBQueue, ANIM_RGB_STROBE, "E5",
+            "RGB LED strobe");
+}
+
+
+static void HandleACCommand(Message* message)
+{
+    StartAnimation(message, xLedQueue, ANIM_GREEN_CHASE, "AC",
+            "green LEDs chase");
+}
+
+// Adjusts the brightness of all SSD digits. SSD_setBrightness only stores
+// the level read by SSDRefreshISR, so no message to another task is needed.
+static void HandleDBCommand(Message* message)
+{
+    unsigned int buttonVal = 0, lastButtonVal = BTN0;
+    u32 level = SSDDisplay.brightness[SSD_DIGIT_RIGHT], newLevel;
+    u32 digit;
+
+    xil_printf("\n----------DB----------\n");
+	xil_printf("change SSD brightness");
+	xil_printf("\n----------------------\n");
+	xil_printf("BTN2: Dimmer\nBTN3: Brighter\n");
+	xil_printf("BTN0: Finish");
+	xil_printf("\n----------------------\n");
+
+    while(1){
+        buttonVal = XGpio_DiscreteRead(&btnInst, 1);
+        newLevel = level;
+
+        // The lowest level is 1 so the command stays readable
+        if(buttonVal == BTN3 && lastButtonVal == 0 && level < SSD_BRIGHTNESS_LEVELS){
+            newLevel = level + 1;
+        } else if (buttonVal == BTN2 && lastButtonVal == 0 && level > 1){
+            newLevel = level - 1;
+        } else if (buttonVal == BTN0  && lastButtonVal == 0){
+        	xil_printf("-------Finished-------\n");
+            break;
+        }
+
+        if(newLevel != level){
+            level = newLevel;
+            for(digit = 0; digit < SSDDisplay.num_digits; digit++){
+                SSD_setBrightness(&SSDDisplay, digit, level);
+            }
+            xil_printf("brightness: %d/%d\n", level, SSD_BRIGHTNESS_LEVELS);
+        }
+
+        lastButtonVal = buttonVal;
+        vTaskDelay(pdMS_TO_TICKS(COMMAND_DELAY));
+    }
+}
+
+// Prints the SSD refresh timing measured since the last DF command and
+// starts a new measurement. Every digit is lit once per two slots of its
+// display, so its refresh rate is half the slot rate.
+static void HandleDFCommand(Message* message)
+{
+    SSD_Stats* stats = SSDDisplay.stats;
+    SSD_Stats* next = stats == &xSSDStats[0] ? &xSSDStats[1] : &xSSDStats[0];
+    u32 mean, worstHz, bucket;
+    s32 from;
+
+    // Hand the interrupt a cleared buffer; once it has switched, nothing
+    // writes the old one any more
+    SSD_statsReset(next);
+    taskENTER_CRITICAL();
+    SSDDisplay.stats = next;
+    taskEXIT_CRITICAL();
+
+    xil_printf("\n----------DF----------\n");
+    xil_printf("SSD refresh timing since last DF\n");
+    if(stats->samples == 0){
+        xil_printf("no slot switches measured\n");
+        xil_printf("-------Finished-------\n");
+        return;
+    }
+
+    mean = (u32) (stats->sum / stats->samples);
+    worstHz = (u32) (COUNTS_PER_SECOND / (2 * (u64) stats->max));
+    xil_printf("slots: %d\n", stats->samples);
+    xil_printf("slot interval (ns): min %d, mean %d, max %d, expected %d\n",
+            CountsToNs(stats->min), CountsToNs(mean), CountsToNs(stats->max),
+            CountsToNs(stats->expected));
+    xil_printf("digit refresh (Hz): mean %d, worst %d, %s %d Hz\n",
+            (u32) (COUNTS_PER_SECOND / (2 * (u64) mean)), worstHz,
+            worstHz >= SSD_FLICKER_HZ ? "above" : "BELOW", SSD_FLICKER_HZ);
+
+    xil_printf("jitter histogram (ns from expected):\n");
+    for(bucket = 0; bucket < SSD_JITTER_BUCKETS; bucket++){
+        from = (s32) (((s64) bucket - SSD_JITTER_BUCKETS / 2) * (1 << SSD_JITTER_SHIFT)
+                * 1000000000LL / (s64) COUNTS_PER_SECOND);
+        if(bucket == 0){
+            xil_printf("  below %7d: %d\n", from + CountsToNs(1 << SSD_JITTER_SHIFT),
+                    stats->histogram[bucket]);
+        } else {
+            xil_printf("  from  %7d: %d\n", from, stats->histogram[bucket]);
+        }
+    }
+    xil_printf("-------Finished-------\n");
+}
+
+#if CPU_LOAD_MEASURE
+static void HandleCCCommand(Message* message)
+{
+    xil_printf("\n----------CC----------\n");
+    xil_printf("CPU utilisation over the last %d ms: %d%%\n",
+            CPU_LOAD_WINDOW_MS, xCPULoad);
+    xil_printf("-------Finished-------\n");
+}
+#endif
+
+// Lists the registered commands in code order: with their help on the UART
+// and as a scrolling list of codes on the SSD. Codes that do not fit on the
+// SSD are counted in a "+N" at the end of the list.
+static void HandleListCommand(Message* message)
+{
+    char text[SSD_MARQUEE_MAX_LEN];
+    u32 slot, length = 0, omitted = 0;
+
+    xil_printf("\n----------00----------\n");
+    for(slot = 0; slot < COMMAND_SLOTS; slot++){
+        if(xCommands[slot].handler == NULL){
+            continue;
+        }
+        xil_printf("%c%c: %s\n", xCommands[slot].code >> 8,
+                xCommands[slot].code & 0xFF, xCommands[slot].help);
+        // Keep room for the "+N" of up to COMMAND_SLOTS codes
+        if(omitted == 0 && length + 3 + sizeof("+256") < sizeof(text)){
+            text[length++] = xCommands[slot].code >> 8;
+            text[length++] = xCommands[slot].code & 0xFF;
+            text[length++] = ' ';
+        } else {
+            omitted++;
+        }
+    }
+    if(omitted != 0){
+        AppendDecimal(text, AppendText(text, length, sizeof(text), "+"),
+                sizeof(text), omitted, 1);
+    } else {
+        text[length > 0 ? length - 1 : 0] = '\0';
+    }
+    PostStatus(text);
+    xil_printf("-------Finished-------\n");
 }
 
 static void HandleUnknownCommand(const char* command)
 {
+    char text[SSD_MARQUEE_MAX_LEN];
+    u32 length;
+
     xil_printf("\n***Command %s is not implemented***\n", command);
+    length = AppendText(text, 0, sizeof(text), "Command ");
+    length = AppendText(text, length, sizeof(text), command);
+    AppendText(text, length, sizeof(text), " not implemented");
+    PostStatus(text);
 }
\ No newline at end of file
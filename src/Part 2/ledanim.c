@@ -0,0 +1,319 @@
+#include "ledanim.h"
+
+/*************************** Function Prototypes ************************/
+
+static void LEDANIM_load(LEDANIM_Player *PlayerPtr);
+static u32 LEDANIM_value(LEDANIM_Player *PlayerPtr);
+static void LEDANIM_show(LEDANIM_Player *PlayerPtr, u32 value, u32 force);
+
+/************************** Function Definitions ************************/
+
+/* -------------------------------------------------------------------- */
+/*** void LEDANIM_begin(LEDANIM *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A LEDANIM to start
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Initialize the engine without players. LEDANIM_tick must then be
+**      called at a fixed rate, which is the unit of the key ticks.
+*/
+void LEDANIM_begin(LEDANIM *InstancePtr) {
+   InstancePtr->num_players = 0;
+}
+
+/* -------------------------------------------------------------------- */
+/*** XStatus LEDANIM_addPlayer(LEDANIM *InstancePtr, LEDANIM_Output Output,
+**         void *OutputRef)
+**
+**   Parameters:
+**      InstancePtr: A LEDANIM to add the player to
+**      Output:      Function writing a value to the LEDs
+**      OutputRef:   Argument passed to Output
+**
+**   Return Value:
+**      XST_SUCCESS, or XST_FAILURE if LEDANIM_MAX_PLAYERS are in use
+**
+**   Description:
+**      Add an idle player. Players are numbered in the order they are
+**      added. Output is called from LEDANIM_tick, and only when the value
+**      changes.
+*/
+XStatus LEDANIM_addPlayer(LEDANIM *InstancePtr, LEDANIM_Output Output,
+      void *OutputRef) {
+   LEDANIM_Player *PlayerPtr;
+
+   if (InstancePtr->num_players == LEDANIM_MAX_PLAYERS)
+      return XST_FAILURE;
+
+   PlayerPtr = &InstancePtr->player[InstancePtr->num_players];
+   PlayerPtr->output = Output;
+   PlayerPtr->output_ref = OutputRef;
+   PlayerPtr->pending = NULL;
+   PlayerPtr->track = NULL;
+   PlayerPtr->value = 0;
+   InstancePtr->num_players++;
+   return XST_SUCCESS;
+}
+
+/* -------------------------------------------------------------------- */
+/*** XStatus LEDANIM_compile(LEDANIM_Track *TrackPtr,
+**         const LEDANIM_Key *keys, u32 count, u32 loop)
+**
+**   Parameters:
+**      TrackPtr: Track to fill in
+**      keys:     Keyframes in playing order
+**      count:    Number of keys, 1 to LEDANIM_MAX_KEYS
+**      loop:     Nonzero to fade or step from the last key back to the
+**                first and repeat; zero to hold the last key
+**
+**   Return Value:
+**      XST_SUCCESS, or XST_FAILURE for a bad key count or a looping track
+**      that takes no time
+**
+**   Description:
+**      Turn keyframes into segments with their per tick slopes, so no
+**      division is left for the interrupt. Keys of zero ticks are jumped
+**      over. The last key of a track that does not loop becomes a final
+**      segment of one tick, whatever its ticks, that shows its value.
+*/
+XStatus LEDANIM_compile(LEDANIM_Track *TrackPtr, const LEDANIM_Key *keys,
+      u32 count, u32 loop) {
+   LEDANIM_Segment *SegmentPtr;
+   u32 from, to, last, i, c;
+   s32 delta;
+   u32 n = 0;
+
+   if (count == 0 || count > LEDANIM_MAX_KEYS)
+      return XST_FAILURE;
+
+   last = loop ? count : count - 1;
+   for (i = 0; i < last; i++) {
+      if (keys[i].ticks == 0)
+         continue;
+      from = keys[i].value;
+      to = keys[(i + 1) % count].value;
+      SegmentPtr = &TrackPtr->segment[n++];
+      SegmentPtr->ticks = keys[i].ticks;
+      SegmentPtr->start = from;
+      for (c = 0; c < LEDANIM_CHANNELS; c++) {
+         delta = (s32) ((to >> (8 * c)) & 0xFF)
+               - (s32) ((from >> (8 * c)) & 0xFF);
+         // Truncating towards zero never overshoots the next key
+         SegmentPtr->slope[c] = keys[i].ease == LEDANIM_FADE
+               ? delta * 65536 / (s32) keys[i].ticks : 0;
+      }
+   }
+   if (!loop) {
+      SegmentPtr = &TrackPtr->segment[n++];
+      SegmentPtr->ticks = 1;
+      SegmentPtr->start = keys[count - 1].value;
+      for (c = 0; c < LEDANIM_CHANNELS; c++)
+         SegmentPtr->slope[c] = 0;
+   } else if (n == 0) {
+      return XST_FAILURE;
+   }
+
+   TrackPtr->num_segments = n;
+   TrackPtr->loop = loop;
+   return XST_SUCCESS;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void LEDANIM_play(LEDANIM *InstancePtr, u32 player,
+**         const LEDANIM_Track *TrackPtr)
+**
+**   Parameters:
+**      InstancePtr: A LEDANIM to use
+**      player:      Player to start, in the order of LEDANIM_addPlayer
+**      TrackPtr:    Compiled track to play from its first key
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Start the track without waiting: the next LEDANIM_tick takes it over
+**      and writes its first value. A track already playing on the player
+**      is replaced.
+*/
+void LEDANIM_play(LEDANIM *InstancePtr, u32 player,
+      const LEDANIM_Track *TrackPtr) {
+   InstancePtr->player[player].pending = TrackPtr;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void LEDANIM_stop(LEDANIM *InstancePtr, u32 player)
+**
+**   Parameters:
+**      InstancePtr: A LEDANIM to use
+**      player:      Player to stop
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Stop the player where it is. Once this returns the interrupt does
+**      not call its output any more, so the caller may write the LEDs
+**      itself. The pending track is dropped first, so the interrupt cannot
+**      start it in between.
+*/
+void LEDANIM_stop(LEDANIM *InstancePtr, u32 player) {
+   InstancePtr->player[player].pending = NULL;
+   InstancePtr->player[player].track = NULL;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 LEDANIM_stopFromISR(LEDANIM *InstancePtr, u32 player)
+**
+**   Parameters:
+**      InstancePtr: A LEDANIM to use
+**      player:      Player to stop
+**
+**   Return Value:
+**      stopped: Nonzero if a track was playing or about to start
+**
+**   Description:
+**      Stop the player from an interrupt other than the one running
+**      LEDANIM_tick, such as a button scan. The stop takes effect at once,
+**      so it is never lost; the return value tells whether the task that
+**      owns the LEDs must be told to take them back.
+*/
+u32 LEDANIM_stopFromISR(LEDANIM *InstancePtr, u32 player) {
+   u32 stopped = LEDANIM_isPlaying(InstancePtr, player);
+
+   LEDANIM_stop(InstancePtr, player);
+   return stopped;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 LEDANIM_isPlaying(LEDANIM *InstancePtr, u32 player)
+**
+**   Parameters:
+**      InstancePtr: A LEDANIM to use
+**      player:      Player to check
+**
+**   Return Value:
+**      playing: Nonzero while the player has a track playing or about to
+**               start, so the interrupt may call its output
+*/
+u32 LEDANIM_isPlaying(LEDANIM *InstancePtr, u32 player) {
+   return InstancePtr->player[player].pending != NULL
+         || InstancePtr->player[player].track != NULL;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void LEDANIM_tick(LEDANIM *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A LEDANIM to advance
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Advance every playing track by one tick: show the current value,
+**      then add the slopes and move to the next segment when this one is
+**      over. A track that does not loop stops after showing its last key.
+*/
+void LEDANIM_tick(LEDANIM *InstancePtr) {
+   LEDANIM_Player *PlayerPtr;
+   LEDANIM_Track const *TrackPtr;
+   u32 force, i, c;
+
+   for (i = 0; i < InstancePtr->num_players; i++) {
+      PlayerPtr = &InstancePtr->player[i];
+      force = 0;
+
+      TrackPtr = PlayerPtr->pending;
+      if (TrackPtr != NULL) {
+         PlayerPtr->pending = NULL;
+         PlayerPtr->track = TrackPtr;
+         PlayerPtr->segment = 0;
+         force = 1;
+         LEDANIM_load(PlayerPtr);
+      }
+
+      TrackPtr = PlayerPtr->track;
+      if (TrackPtr == NULL)
+         continue;
+
+      LEDANIM_show(PlayerPtr, LEDANIM_value(PlayerPtr), force);
+      for (c = 0; c < LEDANIM_CHANNELS; c++)
+         PlayerPtr->acc[c] += TrackPtr->segment[PlayerPtr->segment].slope[c];
+
+      if (--PlayerPtr->remaining == 0) {
+         if (++PlayerPtr->segment == TrackPtr->num_segments) {
+            if (!TrackPtr->loop) {
+               PlayerPtr->track = NULL;
+               continue;
+            }
+            PlayerPtr->segment = 0;
+         }
+         LEDANIM_load(PlayerPtr);
+      }
+   }
+}
+
+/* -------------------------------------------------------------------- */
+/*** static void LEDANIM_load(LEDANIM_Player *PlayerPtr)
+**
+**   Parameters:
+**      PlayerPtr: Player to set up
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Start the current segment of the player's track from its exact
+**      start value, so rounding does not build up from one segment to the
+**      next.
+*/
+static void LEDANIM_load(LEDANIM_Player *PlayerPtr) {
+   const LEDANIM_Segment *SegmentPtr =
+         &PlayerPtr->track->segment[PlayerPtr->segment];
+   u32 c;
+
+   for (c = 0; c < LEDANIM_CHANNELS; c++)
+      PlayerPtr->acc[c] = (s32) (((SegmentPtr->start >> (8 * c)) & 0xFF) << 16);
+   PlayerPtr->remaining = SegmentPtr->ticks;
+}
+
+/* -------------------------------------------------------------------- */
+/*** static u32 LEDANIM_value(LEDANIM_Player *PlayerPtr)
+**
+**   Parameters:
+**      PlayerPtr: Player to read
+**
+**   Return Value:
+**      value: The integer parts of the channel accumulators, packed
+*/
+static u32 LEDANIM_value(LEDANIM_Player *PlayerPtr) {
+   u32 value = 0;
+   u32 c;
+
+   for (c = 0; c < LEDANIM_CHANNELS; c++)
+      value |= ((u32) PlayerPtr->acc[c] >> 16) << (8 * c);
+   return value;
+}
+
+/* -------------------------------------------------------------------- */
+/*** static void LEDANIM_show(LEDANIM_Player *PlayerPtr, u32 value,
+**         u32 force)
+**
+**   Parameters:
+**      PlayerPtr: Player to write
+**      value:     Value to show
+**      force:     Nonzero to write even an unchanged value
+**
+**   Return Value:
+**      none
+*/
+static void LEDANIM_show(LEDANIM_Player *PlayerPtr, u32 value, u32 force) {
+   if (force || value != PlayerPtr->value) {
+      PlayerPtr->value = value;
+      PlayerPtr->output(PlayerPtr->output_ref, value);
+   }
+}
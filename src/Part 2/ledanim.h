@@ -0,0 +1,85 @@
+#ifndef LEDANIM_H
+#define LEDANIM_H
+
+/****************************** Include Files ***************************/
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+/************************** Constant Definitions ************************/
+
+#define LEDANIM_MAX_PLAYERS 2
+#define LEDANIM_MAX_KEYS    8
+
+// Output values are up to four 8-bit channels, interpolated separately
+#define LEDANIM_CHANNELS    4
+
+// How a key moves on to the next one: jump when its ticks are over, or
+// fade linearly over them
+#define LEDANIM_STEP 0
+#define LEDANIM_FADE 1
+
+/**************************** Type Definitions **************************/
+
+typedef void (*LEDANIM_Output)(void *OutputRef, u32 value);
+
+// One keyframe: the value shown at the key, how many ticks pass until the
+// next key and how the value gets there. The key after the last one is
+// the first one again for a looping track.
+typedef struct LEDANIM_Key {
+   u32 value;
+   u32 ticks;
+   u32 ease;
+} LEDANIM_Key;
+
+// Stretch between two keys, precomputed by LEDANIM_compile: the channel
+// values at its start and their change per tick in 16.16 fixed point, so
+// playing it takes one add per channel and tick.
+typedef struct LEDANIM_Segment {
+   u32 ticks;
+   u32 start;
+   s32 slope[LEDANIM_CHANNELS];
+} LEDANIM_Segment;
+
+typedef struct LEDANIM_Track {
+   LEDANIM_Segment segment[LEDANIM_MAX_KEYS];
+   u32 num_segments;
+   u32 loop;
+} LEDANIM_Track;
+
+// One output of the engine and the track it is playing. pending is set by
+// LEDANIM_play and taken over by the interrupt on its next tick; track is
+// cleared by LEDANIM_stop or when a track that does not loop is over.
+typedef struct LEDANIM_Player {
+   LEDANIM_Output output;
+   void *output_ref;
+   LEDANIM_Track const *volatile pending;
+   LEDANIM_Track const *volatile track;
+   u32 segment;
+   u32 remaining;
+   s32 acc[LEDANIM_CHANNELS];
+   u32 value;
+} LEDANIM_Player;
+
+// Keyframe animations of several outputs on one timebase: LEDANIM_tick
+// advances every player, normally from the hardware timer interrupt.
+typedef struct LEDANIM {
+   LEDANIM_Player player[LEDANIM_MAX_PLAYERS];
+   u32 num_players;
+} LEDANIM;
+
+/************************** Function Definitions ************************/
+
+void LEDANIM_begin(LEDANIM *InstancePtr);
+XStatus LEDANIM_addPlayer(LEDANIM *InstancePtr, LEDANIM_Output Output,
+      void *OutputRef);
+XStatus LEDANIM_compile(LEDANIM_Track *TrackPtr, const LEDANIM_Key *keys,
+      u32 count, u32 loop);
+void LEDANIM_play(LEDANIM *InstancePtr, u32 player,
+      const LEDANIM_Track *TrackPtr);
+void LEDANIM_stop(LEDANIM *InstancePtr, u32 player);
+u32 LEDANIM_stopFromISR(LEDANIM *InstancePtr, u32 player);
+u32 LEDANIM_isPlaying(LEDANIM *InstancePtr, u32 player);
+void LEDANIM_tick(LEDANIM *InstancePtr);
+
+#endif // LEDANIM_H
@@ -1,8 +1,87 @@
 #include "pmodkypd.h"
+#include "sleep.h"
 
 /*************************** Function Prototypes ************************/
 
 u8 KYPD_lookupShiftPattern(u16 shift);
+static u16 KYPD_decodeShift(PmodKYPD *InstancePtr, u16 shift[4]);
+static u8 KYPD_keyLabel(PmodKYPD *InstancePtr, u32 key);
+static u8 KYPD_resolveShiftPattern(u16 shift, u8 *certain);
+static u8 KYPD_lookupCalibrated(PmodKYPD *InstancePtr, u32 row, u16 shift);
+static void KYPD_sweep(PmodKYPD *InstancePtr, u32 settle_us, u16 shift[4]);
+static u32 KYPD_sweepIsStable(PmodKYPD *InstancePtr, u32 settle_us,
+      u16 shift[4]);
+
+/**************************** Type Definitions **************************/
+
+typedef struct KYPD_ShiftEntry {
+   u16 pattern;
+   u8  buttons;
+} KYPD_ShiftEntry;
+
+typedef struct KYPD_RowModel {
+   u16 pattern;
+   u16 care;
+} KYPD_RowModel;
+
+/************************** Constant Definitions ************************/
+
+// Keeps the compiler from moving memory accesses across it. The event ring
+// has its producer and consumer on the same core, so ordering the stores
+// of an event against the index that hands it over is enough.
+#define KYPD_BARRIER() __asm__ volatile("" ::: "memory")
+
+// Row reading for every combination of keys held on one row:
+// X(pattern, buttons, care). The patterns were determined experimentally
+// and match this electrical model: the columns are push-pull, so a row with
+// several keys held is connected to several driven columns at once and only
+// reads low while more of them are driven low than high. Where as many
+// columns pull high as low the row sits mid-rail; such bits usually read
+// high but are not reliable, and are cleared in 'care'.
+#define KYPD_ROW_MODEL(X) \
+   X(0xFFFF, 0x0, 0xFFFF) \
+   X(0x00FF, 0x1, 0xFFFF) \
+   X(0x0F0F, 0x2, 0xFFFF) \
+   X(0x0FFF, 0x3, 0xF00F) \
+   X(0x3333, 0x4, 0xFFFF) \
+   X(0x33FF, 0x5, 0xCC33) \
+   X(0x3F3F, 0x6, 0xC3C3) \
+   X(0x033F, 0x7, 0xFFFF) \
+   X(0x5555, 0x8, 0xFFFF) \
+   X(0x55FF, 0x9, 0xAA55) \
+   X(0x5F5F, 0xA, 0xA5A5) \
+   X(0x055F, 0xB, 0xFFFF) \
+   X(0x7777, 0xC, 0x9999) \
+   X(0x1177, 0xD, 0xFFFF) \
+   X(0x1717, 0xE, 0xFFFF) \
+   X(0x177F, 0xF, 0xE997)
+
+// Perfect hash over the known shift patterns: the top 5 bits of the 16-bit
+// product pattern * 0x3D are distinct for every entry of KYPD_shiftTable.
+#define KYPD_SHIFT_HASH_BITS  5
+#define KYPD_SHIFT_HASH_MUL   0x3D
+#define KYPD_SHIFT_HASH(p) \
+   ((u16) ((p) * KYPD_SHIFT_HASH_MUL) >> (16 - KYPD_SHIFT_HASH_BITS))
+
+// Tag stored with every populated slot, so that empty (zeroed) slots can
+// never be mistaken for a "no key" hit.
+#define KYPD_SHIFT_KNOWN      KYPD_UNKNOWN_PATTERN
+
+#define KYPD_SHIFT_ENTRY(p, b, c) \
+   [KYPD_SHIFT_HASH(p)] = { (p), (b) | KYPD_SHIFT_KNOWN },
+
+#define KYPD_MODEL_ENTRY(p, b, c) \
+   [b] = { (p), (c) },
+
+// Slot indices are computed by the compiler from the patterns themselves.
+static const KYPD_ShiftEntry KYPD_shiftTable[1 << KYPD_SHIFT_HASH_BITS] = {
+   KYPD_ROW_MODEL(KYPD_SHIFT_ENTRY)
+};
+
+// The same model indexed by the buttons held on the row
+static const KYPD_RowModel KYPD_rowModel[16] = {
+   KYPD_ROW_MODEL(KYPD_MODEL_ENTRY)
+};
 
 /************************** Function Definitions ************************/
 
@@ -21,10 +100,21 @@ u8 KYPD_lookupShiftPattern(u16 shift);
 */
 void KYPD_begin(PmodKYPD *InstancePtr, u32 GPIO_Address) {
    InstancePtr->GPIO_addr = GPIO_Address;
+   InstancePtr->cols = KYPD_COLS_UNKNOWN;
+   InstancePtr->writes_avoided = 0;
    // Set tri-state register, lower 4 pins are column outputs, upper 4 pins are
    // row inputs
    Xil_Out32(InstancePtr->GPIO_addr + 4, 0xF0);
    InstancePtr->keytable_loaded = FALSE;
+   InstancePtr->unknown_rows = 0;
+   InstancePtr->confidence = 0xFFFF;
+   InstancePtr->last_keystate = 0;
+   InstancePtr->held_keys = 0;
+   InstancePtr->hold_ticks = 0;
+   InstancePtr->scan_step = 0;
+   InstancePtr->idle_steps = 0;
+   KYPD_calibrateBegin(InstancePtr);
+   KYPD_setCols(InstancePtr, KYPD_ALL_COLS);
 }
 
 /* -------------------------------------------------------------------- */
@@ -38,10 +128,18 @@ void KYPD_begin(PmodKYPD *InstancePtr, u32 GPIO_Address) {
 **      none
 **
 **   Description:
-**      Set the column output pins
+**      Set the column output pins. The last value written is kept in
+**      InstancePtr->cols and rewriting it is skipped (counted in
+**      InstancePtr->writes_avoided).
 */
 void KYPD_setCols(PmodKYPD *InstancePtr, u32 cols) {
-   Xil_Out32(InstancePtr->GPIO_addr, cols & 0xF);
+   cols &= 0xF;
+   if (cols == InstancePtr->cols) {
+      InstancePtr->writes_avoided++;
+      return;
+   }
+   Xil_Out32(InstancePtr->GPIO_addr, cols);
+   InstancePtr->cols = cols;
 }
 
 /* -------------------------------------------------------------------- */
@@ -71,20 +169,43 @@ u32 KYPD_getRows(PmodKYPD *InstancePtr) {
 **                Each set of four keys on a single row are grouped together.
 **
 **   Description:
-**      Capture the state of each key on the keypad
+**      Capture the state of each key on the keypad. All columns are driven
+**      low first and the rows are read once; if no row is pulled low no key
+**      is down and the scan returns after a single read (the column write is
+**      skipped when the columns are already low). Only
+**      when a row is active is the full 16 column pattern sweep performed.
 **
 **   Errors:
-**      Multiple key presses may not be detected properly - it can be detected
-**      that multiple keys are pressed, but not which.
+**      Some multi-key combinations cannot be told apart. The keys whose state
+**      is known for certain are set in InstancePtr->confidence; a row whose
+**      pattern fits no combination reads as released and sets its bit in
+**      InstancePtr->unknown_rows.
 */
 u16 KYPD_getKeyStates(PmodKYPD *InstancePtr) {
    u32 rows, cols;
    u16 keystate;
    u16 shift[4] = {0, 0, 0, 0};
 
+   // Idle fast path: with every column driven low a pressed key pulls its
+   // row low, so all rows high means the keypad is idle.
+   KYPD_setCols(InstancePtr, KYPD_ALL_COLS);
+   rows = KYPD_getRows(InstancePtr);
+   if (rows == KYPD_ROWS_IDLE) {
+      InstancePtr->unknown_rows = 0;
+      InstancePtr->confidence = 0xFFFF;
+      return KYPD_NO_KEY;
+   }
+
+   // The all-low pattern is also the first step of the sweep, so reuse the
+   // sample instead of reading it again.
+   shift[0] = rows & 0x1;
+   shift[1] = (rows & 0x2) >> 1;
+   shift[2] = (rows & 0x4) >> 2;
+   shift[3] = (rows & 0x8) >> 3;
+
    // Test each column combination, this will help to detect when multiple keys
    // in the same row are pressed.
-   for (cols = 0; cols < 16; cols++) {
+   for (cols = 1; cols < 16; cols++) {
       KYPD_setCols(InstancePtr, cols);
       rows = KYPD_getRows(InstancePtr);
       // Group bits from each individual row
@@ -95,14 +216,75 @@ u16 KYPD_getKeyStates(PmodKYPD *InstancePtr) {
    }
 
    // Translate shift patterns for each row into button presses.
-   keystate = 0;
-   keystate |= KYPD_lookupShiftPattern(shift[0]);
-   keystate |= KYPD_lookupShiftPattern(shift[1]) << 4;
-   keystate |= KYPD_lookupShiftPattern(shift[2]) << 8;
-   keystate |= KYPD_lookupShiftPattern(shift[3]) << 12;
+   keystate = KYPD_decodeShift(InstancePtr, shift);
+
+   // Leave the columns where the incremental scanner expects them
+   KYPD_setCols(InstancePtr, KYPD_ALL_COLS);
+   InstancePtr->scan_step = 0;
    return keystate;
 }
 
+/* -------------------------------------------------------------------- */
+/*** u32 KYPD_scanStep(PmodKYPD *InstancePtr, u16 *keystate)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      keystate:    Address to store the keystate when a scan completes
+**
+**   Return Value:
+**      TRUE when *keystate holds a newly completed keystate, FALSE otherwise
+**
+**   Description:
+**      Incremental version of KYPD_getKeyStates for use from a periodic tick.
+**      Every call reads the rows for the column pattern written by the
+**      previous call and then writes the next pattern, so each call costs
+**      exactly one read and at most one write, and the pattern gets a full
+**      tick to settle. The partial row patterns are kept in
+**      InstancePtr->shift and a keystate is published after all 16 patterns.
+**      While the keypad is idle the first pattern (all columns low) already
+**      proves it, so the scan stays on that pattern and publishes
+**      KYPD_NO_KEY once every 16 calls. Idle and pressed keystates thus come
+**      at the same rate, and a debouncer takes as long to accept a release
+**      as a press.
+*/
+u32 KYPD_scanStep(PmodKYPD *InstancePtr, u16 *keystate) {
+   u32 rows = KYPD_getRows(InstancePtr);
+   u32 step = InstancePtr->scan_step;
+
+   if (step == 0) {
+      if (rows == KYPD_ROWS_IDLE) {
+         InstancePtr->unknown_rows = 0;
+         InstancePtr->confidence = 0xFFFF;
+         InstancePtr->idle_steps = (InstancePtr->idle_steps + 1) & 0xF;
+         if (InstancePtr->idle_steps != 0)
+            return FALSE;
+         *keystate = KYPD_NO_KEY;
+         return TRUE;
+      }
+      InstancePtr->idle_steps = 0;
+      InstancePtr->shift[0] = 0;
+      InstancePtr->shift[1] = 0;
+      InstancePtr->shift[2] = 0;
+      InstancePtr->shift[3] = 0;
+   }
+
+   // Group bits from each individual row
+   InstancePtr->shift[0] = (InstancePtr->shift[0] << 1) | (rows & 0x1);
+   InstancePtr->shift[1] = (InstancePtr->shift[1] << 1) | (rows & 0x2) >> 1;
+   InstancePtr->shift[2] = (InstancePtr->shift[2] << 1) | (rows & 0x4) >> 2;
+   InstancePtr->shift[3] = (InstancePtr->shift[3] << 1) | (rows & 0x8) >> 3;
+
+   step = (step + 1) & 0xF;
+   InstancePtr->scan_step = step;
+   KYPD_setCols(InstancePtr, step);
+
+   if (step != 0)
+      return FALSE;
+
+   *keystate = KYPD_decodeShift(InstancePtr, InstancePtr->shift);
+   return TRUE;
+}
+
 /* -------------------------------------------------------------------- */
 /*** void KYPD_loadKeyTable(PmodKYPD *InstancePtr, char keytable[16])
 **
@@ -143,7 +325,7 @@ void KYPD_loadKeyTable(PmodKYPD *InstancePtr, u8 keytable[16]) {
 **
 **   Return Value:
 **      status:
-**         XST_SUCCESS when only one key is pressed.
+**         KYPD_SINGLE_KEY when only one key is pressed.
 **           cptr is loaded with a human-readable character when keytable is
 **              loaded.
 **           cptr is loaded with the key index when keytable is not loaded.
@@ -155,75 +337,593 @@ void KYPD_loadKeyTable(PmodKYPD *InstancePtr, u8 keytable[16]) {
 **                     multi-key cases.
 **
 **  Description:
-**    Set the keytable array so that KYPD_getKeyPressed will return will
-**    return the human-readable character that the pressed key represents
+**    Classify keystate as no, single or multiple key press. Takes a constant
+**    number of operations: a zero test, a clear-lowest-bit test and a count
+**    of trailing zeros (RBIT + CLZ on the Cortex-A9).
 */
 u32 KYPD_getKeyPressed(PmodKYPD *InstancePtr, u16 keystate, u8 *cptr) {
-   u8 i = 0;
-   u8 ci = 0;
-   u32 count = 0;
-
-   for (i = 0; i < 16; i++) {
-      // If key reading is 0 (pressed)
-      if (0x1 == (keystate & 0x1)) {
-         count++; // Count the number of pressed keys
-         ci = i;
-      }
-      // Increment through keystate bits
-      keystate >>= 1;
-   }
-
-   if (count > 1) {
-      // Multiple keys pressed, cannot differentiate which
-      return KYPD_MULTI_KEY;
-   } else if (count == 0) {
+   if (keystate == 0) {
       // No key pressed
       return KYPD_NO_KEY;
+   } else if (keystate & (keystate - 1)) {
+      // Clearing the lowest set bit left another one: multiple keys pressed,
+      // cannot differentiate which
+      return KYPD_MULTI_KEY;
    } else {
-      // One key pressed
-      if (InstancePtr->keytable_loaded == TRUE)
-         *cptr = InstancePtr->keytable[ci]; // Return human-readable key label
-      else
-         *cptr = ci; // Return index of pressed key
+      // One key pressed, its index is the number of trailing zeros
+      *cptr = KYPD_keyLabel(InstancePtr, __builtin_ctz(keystate));
       return KYPD_SINGLE_KEY;
    }
 }
 
 /* -------------------------------------------------------------------- */
-/*** u8 KYPD_lookupShiftPattern(u16 shift)
+/*** u32 KYPD_getKeysPressed(PmodKYPD *InstancePtr, u16 keystate, u8 keys[16])
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      keystate:    Status of each key, as for KYPD_getKeyPressed
+**      keys:        Array that receives one entry per pressed key, in key
+**                   index order. Entries are keytable characters when the
+**                   keytable is loaded and key indices otherwise.
+**
+**   Return Value:
+**      count: Number of pressed keys written to keys
+**
+**   Description:
+**      Multi-key companion of KYPD_getKeyPressed. Visits only the set bits
+**      of keystate, lowest first, using count-trailing-zeros.
+*/
+u32 KYPD_getKeysPressed(PmodKYPD *InstancePtr, u16 keystate, u8 keys[16]) {
+   u32 count = __builtin_popcount(keystate);
+   u32 i;
+
+   for (i = 0; i < count; i++) {
+      keys[i] = KYPD_keyLabel(InstancePtr, __builtin_ctz(keystate));
+      keystate &= keystate - 1; // Clear the key just reported
+   }
+   return count;
+}
+
+/* -------------------------------------------------------------------- */
+/*** static u8 KYPD_keyLabel(PmodKYPD *InstancePtr, u32 key)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      key:         Key index, 0 to 15
+**
+**   Return Value:
+**      label: The key's keytable character when the keytable is loaded,
+**             its index otherwise
+*/
+static u8 KYPD_keyLabel(PmodKYPD *InstancePtr, u32 key) {
+   if (InstancePtr->keytable_loaded == TRUE)
+      return InstancePtr->keytable[key]; // Return human-readable key label
+   else
+      return key; // Return index of pressed key
+}
+
+/* -------------------------------------------------------------------- */
+/*** void KYPD_debounceInit(KYPD_Debouncer *DebouncePtr, u32 samples)
+**
+**   Parameters:
+**      DebouncePtr: The debouncer to initialize
+**      samples:     Number of consecutive scans a key must hold a new state
+**                   before the change is accepted (1 to KYPD_DEBOUNCE_MAX).
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Reset the debouncer to "all keys released" and latch the sample count.
+**      Out of range counts are clamped.
+*/
+void KYPD_debounceInit(KYPD_Debouncer *DebouncePtr, u32 samples) {
+   u32 i;
+
+   if (samples < 1)
+      samples = 1;
+   else if (samples > KYPD_DEBOUNCE_MAX)
+      samples = KYPD_DEBOUNCE_MAX;
+
+   DebouncePtr->state = 0;
+   for (i = 0; i < 3; i++) {
+      DebouncePtr->count[i] = 0;
+      // Bit i of (samples - 1), replicated across all 16 keys
+      DebouncePtr->match[i] = ((samples - 1) >> i) & 0x1 ? 0xFFFF : 0x0000;
+   }
+}
+
+/* -------------------------------------------------------------------- */
+/*** u16 KYPD_debounce(KYPD_Debouncer *DebouncePtr, u16 keystate)
+**
+**   Parameters:
+**      DebouncePtr: The debouncer to use
+**      keystate:    Raw keystate, as returned by KYPD_getKeyStates
+**
+**   Return Value:
+**      keystate: The debounced state of all 16 keys
+**
+**   Description:
+**      Filter one raw sample. Each key owns a 3-bit counter stored
+**      bit-sliced across count[0..2] (a vertical counter), so all 16 keys are
+**      advanced together with a few bitwise operations. A key's counter runs
+**      while its raw state disagrees with the debounced state and is cleared
+**      as soon as they agree again; the debounced state only flips once the
+**      disagreement has been seen for the configured number of samples.
+*/
+u16 KYPD_debounce(KYPD_Debouncer *DebouncePtr, u16 keystate) {
+   u16 c0 = DebouncePtr->count[0];
+   u16 c1 = DebouncePtr->count[1];
+   u16 c2 = DebouncePtr->count[2];
+   u16 delta, expired;
+
+   // Keys whose raw state differs from the accepted state
+   delta = keystate ^ DebouncePtr->state;
+
+   // Keys that are changing and have already counted samples - 1 times
+   expired = delta & ~((c0 ^ DebouncePtr->match[0]) |
+                       (c1 ^ DebouncePtr->match[1]) |
+                       (c2 ^ DebouncePtr->match[2]));
+   DebouncePtr->state ^= expired;
+
+   // Ripple-increment every counter, then keep only the still-changing keys
+   delta &= ~expired;
+   DebouncePtr->count[2] = (c2 ^ (c1 & c0)) & delta;
+   DebouncePtr->count[1] = (c1 ^ c0) & delta;
+   DebouncePtr->count[0] = ~c0 & delta;
+
+   return DebouncePtr->state;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void KYPD_eventBufferInit(KYPD_EventBuffer *BufferPtr, KYPD_Event *events,
+**                             u32 size)
+**
+**   Parameters:
+**      BufferPtr: The event ring buffer to initialize
+**      events:    Caller-supplied storage for the ring
+**      size:      Number of entries in events, must be a power of two
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Prepare an empty event ring. The ring has a single producer
+**      (KYPD_pollEvents) and a single consumer (KYPD_readEvent), so it needs
+**      no locking as long as each side stays in one task or ISR.
+*/
+void KYPD_eventBufferInit(KYPD_EventBuffer *BufferPtr, KYPD_Event *events,
+      u32 size) {
+   BufferPtr->events = events;
+   BufferPtr->mask = size - 1;
+   BufferPtr->head = 0;
+   BufferPtr->tail = 0;
+   BufferPtr->dropped = 0;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 KYPD_readEvent(KYPD_EventBuffer *BufferPtr, KYPD_Event *EventPtr)
+**
+**   Parameters:
+**      BufferPtr: The event ring buffer to read from
+**      EventPtr:  Address to copy the oldest event to
+**
+**   Return Value:
+**      TRUE when an event was copied, FALSE when the ring is empty
+**
+**   Description:
+**      Pop the oldest pending key event.
+*/
+u32 KYPD_readEvent(KYPD_EventBuffer *BufferPtr, KYPD_Event *EventPtr) {
+   u32 tail = BufferPtr->tail;
+
+   if (tail == BufferPtr->head)
+      return FALSE;
+
+   // Read the event only after seeing it published, and copy it out before
+   // the slot is handed back to the producer
+   KYPD_BARRIER();
+   *EventPtr = BufferPtr->events[tail & BufferPtr->mask];
+   KYPD_BARRIER();
+   BufferPtr->tail = tail + 1;
+   return TRUE;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void KYPD_setHoldTime(PmodKYPD *InstancePtr, u32 ticks)
 **
 **   Parameters:
 **      InstancePtr: A PmodKYPD device to use
+**      ticks:       How long a key must stay down before KYPD_pollEvents
+**                   reports a KYPD_EVENT_HOLD for it, in the same unit as
+**                   the tick passed to KYPD_pollEvents.
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Set the long-press threshold. A value of 0 disables hold events.
+*/
+void KYPD_setHoldTime(PmodKYPD *InstancePtr, u32 ticks) {
+   InstancePtr->hold_ticks = ticks;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 KYPD_pollEvents(PmodKYPD *InstancePtr, u16 keystate, u32 tick,
+**                       KYPD_EventBuffer *BufferPtr)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      keystate:    Current (preferably debounced) keystate
+**      tick:        Timestamp of the sample, e.g. the RTOS tick count
+**      BufferPtr:   Event ring buffer the events are written to
+**
+**   Return Value:
+**      count: Number of events written. Events that do not fit in the ring
+**             are counted in BufferPtr->dropped instead.
+**
+**   Description:
+**      Compare keystate with the keystate of the previous call and emit a
+**      KYPD_EVENT_PRESS or KYPD_EVENT_RELEASE for every key that changed,
+**      plus one KYPD_EVENT_HOLD for every key that has now been down for at
+**      least the hold time. Each event carries the key index, its keytable
+**      character (the index when no keytable is loaded), the keystate and
+**      the tick. The keystate is the one the event was found in, so a
+**      reader running behind still sees which keys were down with it.
+*/
+u32 KYPD_pollEvents(PmodKYPD *InstancePtr, u16 keystate, u32 tick,
+      KYPD_EventBuffer *BufferPtr) {
+   u16 changed, pressed, held, pending, bit;
+   u32 i, count = 0;
+   u8 type;
+   KYPD_Event *event;
+
+   changed = keystate ^ InstancePtr->last_keystate;
+   pressed = keystate & changed;
+   InstancePtr->last_keystate = keystate;
+
+   // Keys that are down, have not reported a hold yet and are not new
+   held = keystate & ~InstancePtr->held_keys & ~pressed;
+   InstancePtr->held_keys &= keystate;
+   if (InstancePtr->hold_ticks == 0)
+      held = 0;
+
+   // Visit only the keys that can produce an event
+   pending = changed | held;
+   while (pending != 0) {
+      i = __builtin_ctz(pending);
+      pending &= pending - 1;
+      bit = 1 << i;
+
+      if (changed & bit) {
+         type = (pressed & bit) ? KYPD_EVENT_PRESS : KYPD_EVENT_RELEASE;
+         if (type == KYPD_EVENT_PRESS)
+            InstancePtr->press_tick[i] = tick;
+      } else if (tick - InstancePtr->press_tick[i] >= InstancePtr->hold_ticks) {
+         type = KYPD_EVENT_HOLD;
+         InstancePtr->held_keys |= bit;
+      } else {
+         continue;
+      }
+
+      if (BufferPtr->head - BufferPtr->tail > BufferPtr->mask) {
+         // Ring is full
+         BufferPtr->dropped++;
+      } else {
+         event = &BufferPtr->events[BufferPtr->head & BufferPtr->mask];
+         event->type = type;
+         event->key = i;
+         event->ch = KYPD_keyLabel(InstancePtr, i);
+         event->keystate = keystate;
+         event->tick = tick;
+         // Fill in the event before it is published to the reader
+         KYPD_BARRIER();
+         BufferPtr->head++;
+         count++;
+      }
+   }
+
+   return count;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void KYPD_calibrateBegin(PmodKYPD *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Discard any previous calibration and return to the built-in pattern
+**      table. Follow with one KYPD_calibrateKey call per key and finish with
+**      KYPD_calibrateEnd. Calibration drives the columns directly, so no
+**      other scan may run on the device meanwhile.
+*/
+void KYPD_calibrateBegin(PmodKYPD *InstancePtr) {
+   InstancePtr->cal_loaded = FALSE;
+   InstancePtr->cal_captured = 0;
+   InstancePtr->settle_us = 0;
+}
+
+/* -------------------------------------------------------------------- */
+/*** XStatus KYPD_calibrateKey(PmodKYPD *InstancePtr, u32 key,
+**                             u32 *settle_us)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      key:         Index of the key the operator is holding down, 0 to 15
+**      settle_us:   Address to return the shortest column settle time, in
+**                   microseconds, that still gave this key's pattern
+**
+**   Return Value:
+**      status:
+**         XST_SUCCESS when the pattern was recorded.
+**         XST_NO_DATA when the pattern was not stable, or did not look like
+**            the given key alone being held (nothing held, another row
+**            active or the reading was that of no key).
+**         XST_INVALID_PARAM when key is out of range.
+**
+**   Description:
+**      Sweep the columns KYPD_CAL_REPEATS times with a generous settle time
+**      and record the pattern of the key's row. Then retry with shorter
+**      settle times to find the shortest one that still reproduces the
+**      pattern on every sweep. The largest settle time over all calibrated
+**      keys is kept in InstancePtr->settle_us.
+*/
+XStatus KYPD_calibrateKey(PmodKYPD *InstancePtr, u32 key, u32 *settle_us) {
+   u16 reference[4], shift[4];
+   u32 row = key / 4, r, settle;
+
+   if (key >= 16)
+      return XST_INVALID_PARAM;
+
+   if (!KYPD_sweepIsStable(InstancePtr, KYPD_CAL_SETTLE_MAX_US, reference))
+      return XST_NO_DATA;
+
+   for (r = 0; r < 4; r++) {
+      if ((r == row) == (reference[r] == 0xFFFF))
+         return XST_NO_DATA;
+   }
+
+   // Shortest settle time, trying 0, 1, 2, 4 ... microseconds
+   for (settle = 0; settle < KYPD_CAL_SETTLE_MAX_US; settle = settle ? settle * 2 : 1) {
+      if (KYPD_sweepIsStable(InstancePtr, settle, shift) &&
+            shift[row] == reference[row])
+         break;
+   }
+   if (settle > KYPD_CAL_SETTLE_MAX_US)
+      settle = KYPD_CAL_SETTLE_MAX_US;
+
+   InstancePtr->cal_pattern[key] = reference[row];
+   InstancePtr->cal_captured |= 1 << key;
+   if (settle > InstancePtr->settle_us)
+      InstancePtr->settle_us = settle;
+   *settle_us = settle;
+   return XST_SUCCESS;
+}
+
+/* -------------------------------------------------------------------- */
+/*** XStatus KYPD_calibrateEnd(PmodKYPD *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**
+**   Return Value:
+**      status: XST_SUCCESS when all 16 keys were calibrated and the recorded
+**              patterns are in use, XST_FAILURE otherwise
+**
+**   Description:
+**      Switch decoding over to the recorded single-key patterns. Multi-key
+**      combinations keep using the built-in table and model.
+*/
+XStatus KYPD_calibrateEnd(PmodKYPD *InstancePtr) {
+   KYPD_setCols(InstancePtr, KYPD_ALL_COLS);
+   InstancePtr->scan_step = 0;
+
+   if (InstancePtr->cal_captured != 0xFFFF)
+      return XST_FAILURE;
+
+   InstancePtr->cal_loaded = TRUE;
+   return XST_SUCCESS;
+}
+
+/* -------------------------------------------------------------------- */
+/*** static u8 KYPD_lookupCalibrated(PmodKYPD *InstancePtr, u32 row,
+**                                   u16 shift)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      row:         Row the pattern was read on
+**      shift:       The row pattern
+**
+**   Return Value:
+**      buttons: The single button whose recorded pattern equals shift, or
+**               KYPD_UNKNOWN_PATTERN
+**
+**   Description:
+**      Four compares against the calibrated patterns of the row.
+*/
+static u8 KYPD_lookupCalibrated(PmodKYPD *InstancePtr, u32 row, u16 shift) {
+   const u16 *pattern = &InstancePtr->cal_pattern[row * 4];
+   u8 hit;
+
+   hit  = (shift == pattern[0]);
+   hit |= (shift == pattern[1]) << 1;
+   hit |= (shift == pattern[2]) << 2;
+   hit |= (shift == pattern[3]) << 3;
+
+   // Exactly one match identifies the key
+   if (hit == 0 || (hit & (hit - 1)) != 0)
+      return KYPD_UNKNOWN_PATTERN;
+   return hit;
+}
+
+/* -------------------------------------------------------------------- */
+/*** static void KYPD_sweep(PmodKYPD *InstancePtr, u32 settle_us,
+**                          u16 shift[4])
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      settle_us:   Time to wait between writing a column pattern and
+**                   reading the rows
+**      shift:       Receives the four row patterns
+**
+**   Description:
+**      Full 16 pattern column sweep with an explicit settle time.
+*/
+static void KYPD_sweep(PmodKYPD *InstancePtr, u32 settle_us, u16 shift[4]) {
+   u32 cols, rows;
+
+   shift[0] = shift[1] = shift[2] = shift[3] = 0;
+   for (cols = 0; cols < 16; cols++) {
+      KYPD_setCols(InstancePtr, cols);
+      if (settle_us)
+         usleep(settle_us);
+      rows = KYPD_getRows(InstancePtr);
+      shift[0] = (shift[0] << 1) | (rows & 0x1);
+      shift[1] = (shift[1] << 1) | (rows & 0x2) >> 1;
+      shift[2] = (shift[2] << 1) | (rows & 0x4) >> 2;
+      shift[3] = (shift[3] << 1) | (rows & 0x8) >> 3;
+   }
+}
+
+/* -------------------------------------------------------------------- */
+/*** static u32 KYPD_sweepIsStable(PmodKYPD *InstancePtr, u32 settle_us,
+**                                 u16 shift[4])
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      settle_us:   Settle time used for every sweep
+**      shift:       Receives the row patterns of the first sweep
+**
+**   Return Value:
+**      TRUE when KYPD_CAL_REPEATS sweeps all gave the same patterns
+*/
+static u32 KYPD_sweepIsStable(PmodKYPD *InstancePtr, u32 settle_us,
+      u16 shift[4]) {
+   u16 again[4];
+   u32 i;
+
+   KYPD_sweep(InstancePtr, settle_us, shift);
+   for (i = 1; i < KYPD_CAL_REPEATS; i++) {
+      KYPD_sweep(InstancePtr, settle_us, again);
+      if (again[0] != shift[0] || again[1] != shift[1] ||
+            again[2] != shift[2] || again[3] != shift[3])
+         return FALSE;
+   }
+   return TRUE;
+}
+
+/* -------------------------------------------------------------------- */
+/*** static u16 KYPD_decodeShift(PmodKYPD *InstancePtr, u16 shift[4])
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      shift:       The four row patterns of a complete column sweep
+**
+**   Return Value:
+**      keystate: 16 bits, one per key (active high)
+**
+**   Description:
+**      Translate shift patterns for each row into button presses. Single key
+**      patterns recorded by calibration take precedence over the built-in
+**      table, and patterns in neither go through the electrical model in
+**      KYPD_resolveShiftPattern. Which keys are known for certain always
+**      comes from the model, as even a table pattern can fit several key
+**      combinations once its mid-rail bits are ignored; only a calibrated
+**      pattern the model cannot explain is trusted as it is. The certain keys
+**      are set in InstancePtr->confidence. Rows that fit no key combination
+**      at all read as released and are flagged in InstancePtr->unknown_rows.
+*/
+static u16 KYPD_decodeShift(PmodKYPD *InstancePtr, u16 shift[4]) {
+   u32 row;
+   u8 buttons, model, certain;
+   u16 keystate = 0;
+
+   InstancePtr->unknown_rows = 0;
+   InstancePtr->confidence = 0;
+   for (row = 0; row < 4; row++) {
+      buttons = KYPD_UNKNOWN_PATTERN;
+      if (InstancePtr->cal_loaded == TRUE)
+         buttons = KYPD_lookupCalibrated(InstancePtr, row, shift[row]);
+      if (buttons == KYPD_UNKNOWN_PATTERN)
+         buttons = KYPD_lookupShiftPattern(shift[row]);
+      model = KYPD_resolveShiftPattern(shift[row], &certain);
+      if (buttons == KYPD_UNKNOWN_PATTERN)
+         buttons = model;
+      else if (model == KYPD_UNKNOWN_PATTERN)
+         certain = 0xF;
+      keystate |= (buttons & 0xF) << (row * 4);
+      InstancePtr->unknown_rows |= (buttons >> 4) << row;
+      InstancePtr->confidence |= certain << (row * 4);
+   }
+   return keystate;
+}
+
+/* -------------------------------------------------------------------- */
+/*** static u8 KYPD_resolveShiftPattern(u16 shift, u8 *certain)
+**
+**   Parameters:
+**      shift:   A row pattern
+**      certain: Address to return the mask of buttons whose state could be
+**               determined
+**
+**   Return Value:
+**      buttons: The buttons held in every key combination that explains
+**               shift, or KYPD_UNKNOWN_PATTERN when none does.
+**
+**   Description:
+**      Compare shift with the model reading of all 16 combinations, ignoring
+**      the mid-rail bits of each. When exactly one combination fits, the row
+**      is fully resolved. When several fit, the buttons they agree on are
+**      still reported as certain and only the others are ghosted.
+*/
+static u8 KYPD_resolveShiftPattern(u16 shift, u8 *certain) {
+   u32 buttons;
+   u8 all = 0xF, any = 0x0;
+   u32 found = FALSE;
+
+   for (buttons = 0; buttons < 16; buttons++) {
+      const KYPD_RowModel *model = &KYPD_rowModel[buttons];
+      if (((shift ^ model->pattern) & model->care) == 0) {
+         all &= buttons;
+         any |= buttons;
+         found = TRUE;
+      }
+   }
+
+   if (!found) {
+      *certain = 0x0;
+      return KYPD_UNKNOWN_PATTERN;
+   }
+   *certain = ~(all ^ any) & 0xF;
+   return all;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u8 KYPD_lookupShiftPattern(u16 shift)
+**
+**   Parameters:
 **      shift:       A 16-bit array containing the read bits of a single row
 **                   received for each column pattern.
 **
 **   Return Value:
-**      buttons: The button presses detected on this row.
+**      buttons: The button presses detected on this row, or
+**               KYPD_UNKNOWN_PATTERN when the pattern is not in the table.
 **
 **   Description:
 **      Translates reading-pattern detected on a single row into the buttons
-**      pressed on that row.
+**      pressed on that row. The pattern is hashed into KYPD_shiftTable and
+**      compared against the single entry in that slot, so every lookup costs
+**      one multiply, one load and one compare regardless of the input.
 */
 u8 KYPD_lookupShiftPattern(u16 shift) {
-   // Attempt to determine which keys are pressed in this row
-   // These patterns were determined experimentally
-   switch(shift) {
-   case 0xFFFF: return 0x0;
-   case 0x00FF: return 0x1;
-   case 0x0F0F: return 0x2;
-   case 0x0FFF: return 0x3;
-   case 0x3333: return 0x4;
-   case 0x33FF: return 0x5;
-   case 0x3F3F: return 0x6;
-   case 0x033F: return 0x7;
-   case 0x5555: return 0x8;
-   case 0x55FF: return 0x9;
-   case 0x5F5F: return 0xA;
-   case 0x055F: return 0xB;
-   case 0x7777: return 0xC;
-   case 0x1177: return 0xD;
-   case 0x1717: return 0xE;
-   case 0x177F: return 0xF;
-   default:     return 0x0;
-   }
+   const KYPD_ShiftEntry *entry = &KYPD_shiftTable[KYPD_SHIFT_HASH(shift)];
+   u8 match = -(u8) (entry->pattern == shift);
+
+   // A hit strips the KYPD_SHIFT_KNOWN tag; a miss, or an empty slot, leaves
+   // only the tag set, which is KYPD_UNKNOWN_PATTERN.
+   return (entry->buttons & match) ^ KYPD_SHIFT_KNOWN;
 }
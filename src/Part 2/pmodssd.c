@@ -0,0 +1,655 @@
+#include "pmodssd.h"
+
+/*************************** Function Prototypes ************************/
+
+static void SSD_marqueeAdvance(PmodSSD *InstancePtr);
+static void SSD_statsSample(SSD_Stats *StatsPtr, u32 display);
+
+/************************** Constant Definitions ************************/
+
+// Keeps the compiler from moving memory accesses across it, so plain
+// stores are done before a following store that publishes them to the
+// refresh interrupt
+#define SSD_BARRIER() __asm__ volatile("" ::: "memory")
+
+// Segment pattern of every byte value. Covers the hex digits plus every
+// other letter and symbol a seven-segment digit can show recognisably;
+// lowercase letters use their lowercase shape where one exists. Anything
+// else, including space, is blank.
+static const u8 SSD_font[256] = {
+   ['"'] = SSD_SEG_B | SSD_SEG_F,
+   ['\''] = SSD_SEG_B,
+   ['('] = SSD_SEG_A | SSD_SEG_D | SSD_SEG_E | SSD_SEG_F,
+   [')'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_C | SSD_SEG_D,
+   [','] = SSD_SEG_C,
+   ['-'] = SSD_SEG_G,
+   ['/'] = SSD_SEG_B | SSD_SEG_E | SSD_SEG_G,
+   ['0'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_C | SSD_SEG_D | SSD_SEG_E | SSD_SEG_F,
+   ['1'] = SSD_SEG_B | SSD_SEG_C,
+   ['2'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_D | SSD_SEG_E | SSD_SEG_G,
+   ['3'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_C | SSD_SEG_D | SSD_SEG_G,
+   ['4'] = SSD_SEG_B | SSD_SEG_C | SSD_SEG_F | SSD_SEG_G,
+   ['5'] = SSD_SEG_A | SSD_SEG_C | SSD_SEG_D | SSD_SEG_F | SSD_SEG_G,
+   ['6'] = SSD_SEG_A | SSD_SEG_C | SSD_SEG_D | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['7'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_C,
+   ['8'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_C | SSD_SEG_D | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['9'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_C | SSD_SEG_F | SSD_SEG_G,
+   ['<'] = SSD_SEG_D | SSD_SEG_E | SSD_SEG_G,
+   ['='] = SSD_SEG_D | SSD_SEG_G,
+   ['>'] = SSD_SEG_C | SSD_SEG_D | SSD_SEG_G,
+   ['?'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_E | SSD_SEG_G,
+   ['A'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_C | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['B'] = SSD_SEG_C | SSD_SEG_D | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['C'] = SSD_SEG_A | SSD_SEG_D | SSD_SEG_E | SSD_SEG_F,
+   ['D'] = SSD_SEG_B | SSD_SEG_C | SSD_SEG_D | SSD_SEG_E | SSD_SEG_G,
+   ['E'] = SSD_SEG_A | SSD_SEG_D | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['F'] = SSD_SEG_A | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['G'] = SSD_SEG_A | SSD_SEG_C | SSD_SEG_D | SSD_SEG_E | SSD_SEG_F,
+   ['H'] = SSD_SEG_B | SSD_SEG_C | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['I'] = SSD_SEG_E | SSD_SEG_F,
+   ['J'] = SSD_SEG_B | SSD_SEG_C | SSD_SEG_D | SSD_SEG_E,
+   ['L'] = SSD_SEG_D | SSD_SEG_E | SSD_SEG_F,
+   ['N'] = SSD_SEG_C | SSD_SEG_E | SSD_SEG_G,
+   ['O'] = SSD_SEG_C | SSD_SEG_D | SSD_SEG_E | SSD_SEG_G,
+   ['P'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['Q'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_C | SSD_SEG_F | SSD_SEG_G,
+   ['R'] = SSD_SEG_E | SSD_SEG_G,
+   ['S'] = SSD_SEG_A | SSD_SEG_C | SSD_SEG_D | SSD_SEG_F | SSD_SEG_G,
+   ['T'] = SSD_SEG_D | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['U'] = SSD_SEG_B | SSD_SEG_C | SSD_SEG_D | SSD_SEG_E | SSD_SEG_F,
+   ['Y'] = SSD_SEG_B | SSD_SEG_C | SSD_SEG_D | SSD_SEG_F | SSD_SEG_G,
+   ['Z'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_D | SSD_SEG_E | SSD_SEG_G,
+   ['['] = SSD_SEG_A | SSD_SEG_D | SSD_SEG_E | SSD_SEG_F,
+   ['\\'] = SSD_SEG_C | SSD_SEG_F | SSD_SEG_G,
+   [']'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_C | SSD_SEG_D,
+   ['^'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_F,
+   ['_'] = SSD_SEG_D,
+   ['`'] = SSD_SEG_F,
+   ['a'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_C | SSD_SEG_D | SSD_SEG_E | SSD_SEG_G,
+   ['b'] = SSD_SEG_C | SSD_SEG_D | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['c'] = SSD_SEG_D | SSD_SEG_E | SSD_SEG_G,
+   ['d'] = SSD_SEG_B | SSD_SEG_C | SSD_SEG_D | SSD_SEG_E | SSD_SEG_G,
+   ['e'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_D | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['f'] = SSD_SEG_A | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['g'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_C | SSD_SEG_D | SSD_SEG_F | SSD_SEG_G,
+   ['h'] = SSD_SEG_C | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['i'] = SSD_SEG_C,
+   ['j'] = SSD_SEG_B | SSD_SEG_C | SSD_SEG_D,
+   ['l'] = SSD_SEG_E | SSD_SEG_F,
+   ['n'] = SSD_SEG_C | SSD_SEG_E | SSD_SEG_G,
+   ['o'] = SSD_SEG_C | SSD_SEG_D | SSD_SEG_E | SSD_SEG_G,
+   ['p'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['q'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_C | SSD_SEG_F | SSD_SEG_G,
+   ['r'] = SSD_SEG_E | SSD_SEG_G,
+   ['s'] = SSD_SEG_A | SSD_SEG_C | SSD_SEG_D | SSD_SEG_F | SSD_SEG_G,
+   ['t'] = SSD_SEG_D | SSD_SEG_E | SSD_SEG_F | SSD_SEG_G,
+   ['u'] = SSD_SEG_C | SSD_SEG_D | SSD_SEG_E,
+   ['y'] = SSD_SEG_B | SSD_SEG_C | SSD_SEG_D | SSD_SEG_F | SSD_SEG_G,
+   ['z'] = SSD_SEG_A | SSD_SEG_B | SSD_SEG_D | SSD_SEG_E | SSD_SEG_G,
+   ['|'] = SSD_SEG_E | SSD_SEG_F,
+   ['~'] = SSD_SEG_A,
+};
+
+// Character of each digit value for SSD_setNumber
+static const char SSD_digitChar[16] = {
+   '0', '1', '2', '3', '4', '5', '6', '7',
+   '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+};
+
+// Powers of ten, so decimal digits are found by subtraction
+static const u32 SSD_pow10[10] = {
+   1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/************************** Function Definitions ************************/
+
+/* -------------------------------------------------------------------- */
+/*** void SSD_begin(PmodSSD *InstancePtr, XGpio *GpioPtr, unsigned channel)
+**
+**   Parameters:
+**      InstancePtr: A PmodSSD device to start
+**      GpioPtr:     The initialized XGpio the display is wired to
+**      channel:     GPIO channel of the display
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Initialize the driver for a single display, with both frame buffers
+**      blank, every digit at full brightness and no blanking interval. More displays can be
+**      chained with SSD_addDisplay. Nothing is shown until SSD_refresh is
+**      called periodically, normally from a timer interrupt.
+*/
+void SSD_begin(PmodSSD *InstancePtr, XGpio *GpioPtr, unsigned channel) {
+   u32 i;
+
+   InstancePtr->num_displays = 0;
+   InstancePtr->num_digits = 0;
+   InstancePtr->next_display = 0;
+   InstancePtr->front = 0;
+   InstancePtr->blanking = 0;
+   InstancePtr->marquee = 0;
+   InstancePtr->marquee_len = 0;
+   InstancePtr->stats = NULL;
+   for (i = 0; i < SSD_MAX_DIGITS; i++) {
+      InstancePtr->frame[0][i] = 0;
+      InstancePtr->frame[1][i] = 0;
+      InstancePtr->brightness[i] = SSD_BRIGHTNESS_LEVELS;
+   }
+   SSD_addDisplay(InstancePtr, GpioPtr, channel);
+}
+
+/* -------------------------------------------------------------------- */
+/*** XStatus SSD_addDisplay(PmodSSD *InstancePtr, XGpio *GpioPtr,
+**                          unsigned channel)
+**
+**   Parameters:
+**      InstancePtr: A PmodSSD device to extend
+**      GpioPtr:     The initialized XGpio the display is wired to
+**      channel:     GPIO channel of the display
+**
+**   Return Value:
+**      status: XST_SUCCESS, or XST_FAILURE when SSD_MAX_DISPLAYS are
+**              already chained
+**
+**   Description:
+**      Chain another display to the right of the existing digits, wired
+**      as a Pmod SSD. Must be called before the refresh interrupt is
+**      started.
+*/
+XStatus SSD_addDisplay(PmodSSD *InstancePtr, XGpio *GpioPtr, unsigned channel) {
+   u32 i = InstancePtr->num_displays;
+
+   if (i >= SSD_MAX_DISPLAYS)
+      return XST_FAILURE;
+
+   InstancePtr->display[i].GpioPtr = GpioPtr;
+   InstancePtr->display[i].channel = channel;
+   InstancePtr->display[i].segment_mask = SSD_SEGMENT_MASK;
+   InstancePtr->display[i].select_shift = SSD_SELECT_SHIFT;
+   InstancePtr->display[i].digit = 0;
+   InstancePtr->display[i].level = SSD_BRIGHTNESS_LEVELS;
+   InstancePtr->display[i].phase = 0;
+   InstancePtr->num_displays = i + 1;
+   InstancePtr->num_digits = (i + 1) * SSD_DIGITS;
+   return XST_SUCCESS;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void SSD_setWiring(PmodSSD *InstancePtr, u32 display, u32 segment_mask,
+**         u32 select_shift)
+**
+**   Parameters:
+**      InstancePtr:  A PmodSSD device to use
+**      display:      Index of the display in the chain
+**      segment_mask: Segments the display has, SSD_SEG_DP included for an
+**                    eight-segment display
+**      select_shift: GPIO bit selecting its right digit
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Describe a display not wired like the Pmod SSD, for example one with
+**      the decimal point on bit 7 and the digit select on bit 8. Must be
+**      called before the refresh interrupt is started.
+*/
+void SSD_setWiring(PmodSSD *InstancePtr, u32 display, u32 segment_mask,
+      u32 select_shift) {
+   InstancePtr->display[display].segment_mask = segment_mask;
+   InstancePtr->display[display].select_shift = select_shift;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void SSD_setDigit(PmodSSD *InstancePtr, u32 digit, u8 segments)
+**
+**   Parameters:
+**      InstancePtr: A PmodSSD device to use
+**      digit:       Digit number, counted from the left of the chain
+**      segments:    Segment pattern, SSD_SEG_A to SSD_SEG_G and SSD_SEG_DP
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Store a digit in the back buffer. It is not shown until the next
+**      SSD_swap, so a frame built from several calls appears all at once.
+**      Digits not set keep the value of the frame currently shown.
+*/
+void SSD_setDigit(PmodSSD *InstancePtr, u32 digit, u8 segments) {
+   InstancePtr->frame[InstancePtr->front ^ 1][digit] = segments;
+}
+
+/* -------------------------------------------------------------------- */
+/*** XStatus SSD_setNumber(PmodSSD *InstancePtr, u32 digit, u32 width,
+**         u32 value, u32 base, u32 point)
+**
+**   Parameters:
+**      InstancePtr: A PmodSSD device to use
+**      digit:       Leftmost digit of the field
+**      width:       Number of digits of the field
+**      value:       Number to show, scaled by base^point for fixed point
+**      base:        SSD_BASE_DEC or SSD_BASE_HEX
+**      point:       Digits after the decimal point, 0 for an integer
+**
+**   Return Value:
+**      status: XST_SUCCESS, or XST_FAILURE when the field does not fit the
+**              display or value needs more than width digits, in which
+**              case the field shows dashes
+**
+**   Description:
+**      Render value right-aligned into the back buffer, to be shown by the
+**      next SSD_swap. Leading zeros are blank up to the digit before the
+**      point, which carries the decimal point when point is not 0. Hex
+**      digits come from shifts and decimal digits from subtracting powers
+**      of ten, so no division is done. For example 125 with point 1 shows
+**      12.5 on an eight-segment display.
+*/
+XStatus SSD_setNumber(PmodSSD *InstancePtr, u32 digit, u32 width, u32 value,
+      u32 base, u32 point) {
+   u32 overflow;
+   u32 lead = 1;
+   u32 pos, d;
+   u8 segments;
+
+   if (width == 0 || digit + width > InstancePtr->num_digits)
+      return XST_FAILURE;
+
+   if (base == SSD_BASE_HEX)
+      overflow = width < 8 && (value >> (4 * width)) != 0;
+   else
+      overflow = width < 10 && value >= SSD_pow10[width];
+   if (overflow) {
+      for (pos = 0; pos < width; pos++)
+         SSD_setDigit(InstancePtr, digit + pos, SSD_SEG_G);
+      return XST_FAILURE;
+   }
+
+   // pos counts digits from the right, the most significant one first
+   for (pos = width; pos-- > 0;) {
+      if (base == SSD_BASE_HEX) {
+         d = (value >> (4 * pos)) & 0xF;
+      } else {
+         for (d = 0; value >= SSD_pow10[pos]; d++)
+            value -= SSD_pow10[pos];
+      }
+      lead = lead && d == 0 && pos > point;
+      segments = lead ? 0 : SSD_font[(u8) SSD_digitChar[d]];
+      if (pos == point && point != 0)
+         segments |= SSD_SEG_DP;
+      SSD_setDigit(InstancePtr, digit + width - 1 - pos, segments);
+   }
+   return XST_SUCCESS;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void SSD_swap(PmodSSD *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A PmodSSD device to use
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Publish the back buffer. The front index changes in a single word
+**      store, so SSD_refresh sees either the old frame or the new one and
+**      never a mix, without any lock. The new front is then copied into the
+**      new back buffer so the next frame starts from what is shown.
+**
+**      The back buffer belongs to one writer: only a single task may call
+**      SSD_setDigit and SSD_swap on a given display.
+*/
+void SSD_swap(PmodSSD *InstancePtr) {
+   u32 front = InstancePtr->front ^ 1;
+   u32 i;
+
+   InstancePtr->front = front;
+   for (i = 0; i < InstancePtr->num_digits; i++)
+      InstancePtr->frame[front ^ 1][i] = InstancePtr->frame[front][i];
+}
+
+/* -------------------------------------------------------------------- */
+/*** void SSD_setBrightness(PmodSSD *InstancePtr, u32 digit, u32 level)
+**
+**   Parameters:
+**      InstancePtr: A PmodSSD device to use
+**      digit:       Digit number, counted from the left of the chain
+**      level:       0 (off) to SSD_BRIGHTNESS_LEVELS (fully on), larger
+**                   values are clamped
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Set the duty cycle of a digit within its multiplex slot. Takes
+**      effect from the next slot of that digit, as SSD_refresh latches the
+**      level when the slot starts; any task may call it.
+*/
+void SSD_setBrightness(PmodSSD *InstancePtr, u32 digit, u32 level) {
+   if (level > SSD_BRIGHTNESS_LEVELS)
+      level = SSD_BRIGHTNESS_LEVELS;
+   InstancePtr->brightness[digit] = level;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void SSD_setBlanking(PmodSSD *InstancePtr, u32 ticks)
+**
+**   Parameters:
+**      InstancePtr: A PmodSSD device to use
+**      ticks:       Blanking interval in refresh calls of a display, up to
+**                   SSD_MAX_BLANKING; larger values are clamped
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Turn the segments of each display off for 'ticks' refresh calls
+**      before it switches digits, so the pattern of the old digit is not
+**      driven while the digit select changes. When the refresh runs on
+**      every hardware timer tick of a single display, the interval is in
+**      timer ticks. Each slot grows by the interval, so the refresh rate of
+**      a digit drops by SSD_BRIGHTNESS_LEVELS / (SSD_BRIGHTNESS_LEVELS +
+**      ticks).
+*/
+void SSD_setBlanking(PmodSSD *InstancePtr, u32 ticks) {
+   if (ticks > SSD_MAX_BLANKING)
+      ticks = SSD_MAX_BLANKING;
+   InstancePtr->blanking = ticks;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void SSD_refresh(PmodSSD *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A PmodSSD device to use
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Advance the multiplexing of the next display in the chain by one
+**      call. The displays are independent, so each one keeps one of its
+**      digits lit all the time and every digit of the chain gets the same
+**      half duty. A slot starts with the blanking interval, if any, whose
+**      first call turns the segments off under the old digit select. The
+**      call after the interval switches the display to its other digit and
+**      drives its segments from the front buffer, or from the marquee
+**      stream while one runs; the call matching the digit's brightness
+**      blanks it.
+**
+**      A call touches one display and makes at most one GPIO write, so its
+**      cost does not depend on the number of digits. Called at a fixed rate
+**      from the timer interrupt, each digit is refreshed at the call rate
+**      divided by 2 * (SSD_BRIGHTNESS_LEVELS + blanking) * num_displays.
+*/
+void SSD_refresh(PmodSSD *InstancePtr) {
+   u32 n = InstancePtr->next_display;
+   SSD_Display *DisplayPtr = &InstancePtr->display[n];
+   u32 blanking = InstancePtr->blanking;
+   u32 phase = DisplayPtr->phase;
+   u32 digit = DisplayPtr->digit;
+   u32 index;
+   u32 segments;
+
+   InstancePtr->next_display = n + 1 < InstancePtr->num_displays ? n + 1 : 0;
+
+   if (phase == blanking) {
+      if (InstancePtr->stats != NULL)
+         SSD_statsSample(InstancePtr->stats, n);
+      digit ^= 1;
+      DisplayPtr->digit = digit;
+      index = n * SSD_DIGITS + digit;
+      DisplayPtr->level = InstancePtr->brightness[index];
+      if (InstancePtr->marquee_len != 0) {
+         if (index == 0)
+            SSD_marqueeAdvance(InstancePtr);
+         segments = InstancePtr->marquee[InstancePtr->marquee_pos + index];
+      } else {
+         segments = InstancePtr->frame[InstancePtr->front][index];
+      }
+      if (DisplayPtr->level == 0)
+         segments = 0;
+      XGpio_DiscreteWrite(DisplayPtr->GpioPtr, DisplayPtr->channel,
+            (segments & DisplayPtr->segment_mask)
+                  | (digit << DisplayPtr->select_shift));
+   } else if (phase == 0 || phase == blanking + DisplayPtr->level) {
+      XGpio_DiscreteWrite(DisplayPtr->GpioPtr, DisplayPtr->channel,
+            digit << DisplayPtr->select_shift);
+   }
+   phase++;
+   DisplayPtr->phase = phase < blanking + SSD_BRIGHTNESS_LEVELS ? phase : 0;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void SSD_statsBegin(PmodSSD *InstancePtr, SSD_Stats *StatsPtr,
+**         u32 expected, u32 bucket_shift)
+**
+**   Parameters:
+**      InstancePtr:  A PmodSSD device to measure
+**      StatsPtr:     Caller-supplied statistics
+**      expected:     Nominal slot interval in global timer counts
+**      bucket_shift: Histogram bucket width is 2^bucket_shift counts
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Clear StatsPtr and have SSD_refresh timestamp every slot switch
+**      into it with the global timer. The refresh path only compares, adds
+**      and shifts; the mean is left to the reader as sum / samples.
+**
+**      The statistics are updated from the refresh interrupt, so a task
+**      reading or resetting them must keep that interrupt off meanwhile.
+*/
+void SSD_statsBegin(PmodSSD *InstancePtr, SSD_Stats *StatsPtr, u32 expected,
+      u32 bucket_shift) {
+   StatsPtr->expected = expected;
+   StatsPtr->bucket_shift = bucket_shift;
+   SSD_statsReset(StatsPtr);
+   InstancePtr->stats = StatsPtr;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void SSD_statsReset(SSD_Stats *StatsPtr)
+**
+**   Parameters:
+**      StatsPtr: Statistics to clear
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Start a new measurement. The first slot switch of each display
+**      after a reset only records its timestamp.
+*/
+void SSD_statsReset(SSD_Stats *StatsPtr) {
+   u32 i;
+
+   for (i = 0; i < SSD_MAX_DISPLAYS; i++)
+      StatsPtr->last[i] = 0;
+   StatsPtr->samples = 0;
+   StatsPtr->min = 0xFFFFFFFF;
+   StatsPtr->max = 0;
+   StatsPtr->sum = 0;
+   for (i = 0; i < SSD_JITTER_BUCKETS; i++)
+      StatsPtr->histogram[i] = 0;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 SSD_decode(u8 key_value, u8 cathode)
+**
+**   Parameters:
+**      key_value: Character to show
+**      cathode:   Digit select, 0 for the left digit, 1 for the right
+**
+**   Return Value:
+**      value: GPIO value showing key_value on the selected digit
+**
+**   Description:
+**      Translate a character to its segment pattern with one table load and
+**      OR in the digit select bit without branching.
+*/
+u32 SSD_decode(u8 key_value, u8 cathode) {
+   return SSD_font[key_value] | ((u32) (cathode != 0) << SSD_SELECT_SHIFT);
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 SSD_marqueeCompile(PmodSSD *InstancePtr, const char *text,
+**         u8 *stream, u32 size)
+**
+**   Parameters:
+**      InstancePtr: The PmodSSD device the marquee is for
+**      text:        NUL-terminated string to scroll
+**      stream:      Buffer receiving the segment stream
+**      size:        Size of stream in bytes, SSD_MARQUEE_SIZE(strlen(text))
+**                   is always enough
+**
+**   Return Value:
+**      length: Number of scroll positions in the stream, 0 if text does not
+**              fit
+**
+**   Description:
+**      Decode text once into the segment stream SSD_marqueeStart scrolls.
+**      The text is followed by one blank per digit of the chain, so it
+**      scrolls completely out before it repeats, and then by its first
+**      num_digits - 1 bytes again so every scroll position is a plain run
+**      of num_digits bytes.
+*/
+u32 SSD_marqueeCompile(PmodSSD *InstancePtr, const char *text, u8 *stream,
+      u32 size) {
+   u32 digits = InstancePtr->num_digits;
+   u32 length = 0;
+   u32 i;
+
+   while (text[length] != '\0')
+      length++;
+   if (size < length + 2 * digits - 1)
+      return 0;
+
+   for (i = 0; i < length; i++)
+      stream[i] = SSD_font[(u8) text[i]];
+   for (i = 0; i < digits; i++)
+      stream[length + i] = 0;
+   length += digits;
+   for (i = 0; i < digits - 1; i++)
+      stream[length + i] = stream[i];
+   return length;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void SSD_marqueeStart(PmodSSD *InstancePtr, const u8 *stream,
+**         u32 length, u32 frames_per_step)
+**
+**   Parameters:
+**      InstancePtr:     A PmodSSD device to use
+**      stream:          Segment stream from SSD_marqueeCompile, which must
+**                       stay unchanged until the marquee is stopped
+**      length:          Scroll positions returned by SSD_marqueeCompile
+**      frames_per_step: Refreshes of the whole display between two scroll
+**                       steps, at least 1
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Scroll stream across the digits, repeating until SSD_marqueeStop,
+**      in place of the frame buffers. The marquee is disabled while its
+**      fields change and enabled by the final store of length, behind a
+**      compiler barrier, so the refresh interrupt never sees a
+**      half-started marquee.
+*/
+void SSD_marqueeStart(PmodSSD *InstancePtr, const u8 *stream, u32 length,
+      u32 frames_per_step) {
+   InstancePtr->marquee_len = 0;
+   InstancePtr->marquee = stream;
+   InstancePtr->marquee_pos = 0;
+   InstancePtr->marquee_frames = frames_per_step;
+   InstancePtr->marquee_count = frames_per_step;
+   SSD_BARRIER();
+   InstancePtr->marquee_len = length;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void SSD_marqueeStop(PmodSSD *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A PmodSSD device to use
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Return the display to the frame buffers. Once this returns the
+**      refresh interrupt no longer reads the marquee stream, so its buffer
+**      may be reused.
+*/
+void SSD_marqueeStop(PmodSSD *InstancePtr) {
+   InstancePtr->marquee_len = 0;
+}
+
+/* -------------------------------------------------------------------- */
+/*** static void SSD_marqueeAdvance(PmodSSD *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A PmodSSD device with a running marquee
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Count one display frame and scroll the marquee by one position
+**      every marquee_frames frames. Called when the first digit of the
+**      chain starts its slot; the other digits pick up the new position
+**      as their own slots start.
+*/
+static void SSD_marqueeAdvance(PmodSSD *InstancePtr) {
+   u32 pos;
+
+   if (--InstancePtr->marquee_count != 0)
+      return;
+   InstancePtr->marquee_count = InstancePtr->marquee_frames;
+   pos = InstancePtr->marquee_pos + 1;
+   InstancePtr->marquee_pos = pos < InstancePtr->marquee_len ? pos : 0;
+}
+
+/* -------------------------------------------------------------------- */
+/*** static void SSD_statsSample(SSD_Stats *StatsPtr, u32 display)
+**
+**   Parameters:
+**      StatsPtr: Statistics to update
+**      display:  Index of the display switching slots
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Timestamp a slot switch and account the interval since the previous
+**      one of the same display. The deviation from the expected interval is
+**      bucketed with an arithmetic shift and clamped to the histogram.
+*/
+static void SSD_statsSample(SSD_Stats *StatsPtr, u32 display) {
+   XTime now;
+   u32 interval;
+   s32 bucket;
+
+   XTime_GetTime(&now);
+   if (StatsPtr->last[display] != 0) {
+      interval = (u32) (now - StatsPtr->last[display]);
+      if (interval < StatsPtr->min)
+         StatsPtr->min = interval;
+      if (interval > StatsPtr->max)
+         StatsPtr->max = interval;
+      StatsPtr->sum += interval;
+      StatsPtr->samples++;
+
+      bucket = ((s32) (interval - StatsPtr->expected) >> StatsPtr->bucket_shift)
+            + SSD_JITTER_BUCKETS / 2;
+      if (bucket < 0)
+         bucket = 0;
+      else if (bucket >= SSD_JITTER_BUCKETS)
+         bucket = SSD_JITTER_BUCKETS - 1;
+      StatsPtr->histogram[bucket]++;
+   }
+   StatsPtr->last[display] = now;
+}
\ No newline at end of file
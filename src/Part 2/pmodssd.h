@@ -0,0 +1,139 @@
+#ifndef PMODSSD_H
+#define PMODSSD_H
+
+/****************************** Include Files ***************************/
+
+#include "xil_types.h"
+#include "xgpio.h"
+#include "xstatus.h"
+#include "xtime_l.h"
+
+/************************** Constant Definitions ************************/
+
+// Every Pmod SSD has two digits on one GPIO channel. Several of them can be
+// chained on further GPIO devices or channels; digits are then numbered
+// left to right across the chain, digit n sitting on display n / 2.
+#define SSD_DIGITS      2
+#define SSD_MAX_DISPLAYS 4
+#define SSD_MAX_DIGITS  (SSD_MAX_DISPLAYS * SSD_DIGITS)
+#define SSD_DIGIT_LEFT  0
+#define SSD_DIGIT_RIGHT 1
+
+// Frame bytes hold all eight segments, decimal point included. How they
+// reach a display is set per display: on the Pmod SSD bit 7 of the GPIO
+// selects the digit (0 for the left, 1 for the right) and the decimal
+// point is not wired, so only segments A to G are driven. SSD_setWiring
+// describes displays wired otherwise.
+#define SSD_SELECT_SHIFT 7
+#define SSD_SEGMENT_MASK 0x7F
+
+// Number bases of SSD_setNumber
+#define SSD_BASE_DEC 10
+#define SSD_BASE_HEX 16
+
+// Each digit is lit for one slot of SSD_BRIGHTNESS_LEVELS refresh calls of
+// its display. A digit at brightness n is driven for the first n calls of
+// its slot and blanked for the rest; SSD_BRIGHTNESS_LEVELS is fully on, 0
+// is off.
+#define SSD_BRIGHTNESS_LEVELS 8
+
+// Longest blanking interval accepted by SSD_setBlanking
+#define SSD_MAX_BLANKING 8
+
+// Bytes needed to compile a marquee of len characters for any chain: the
+// text, a blank gap of one digit per digit shown between repeats, and one
+// digit less wrapped from the start so the last positions can be read
+// without a modulo
+#define SSD_MARQUEE_SIZE(len) ((len) + 2 * SSD_MAX_DIGITS - 1)
+
+// Buckets of the slot interval jitter histogram. The middle bucket holds
+// the intervals within one bucket width above the nominal interval; the
+// first and last ones collect everything further off.
+#define SSD_JITTER_BUCKETS 16
+
+// GPIO bit of each segment, as wired on the Pmod SSD
+#define SSD_SEG_D 0x01
+#define SSD_SEG_E 0x02
+#define SSD_SEG_F 0x04
+#define SSD_SEG_A 0x08
+#define SSD_SEG_B 0x10
+#define SSD_SEG_C 0x20
+#define SSD_SEG_G 0x40
+#define SSD_SEG_DP 0x80
+
+/**************************** Type Definitions **************************/
+
+// One Pmod SSD of a chain: its GPIO and wiring, the digit it currently
+// lights, the brightness that digit got at the start of its slot and the
+// position within the slot, blanking interval included
+typedef struct SSD_Display {
+   XGpio *GpioPtr;
+   unsigned channel;
+   u32 segment_mask;
+   u32 select_shift;
+   u32 digit;
+   u32 level;
+   u32 phase;
+} SSD_Display;
+
+// Refresh timing measured by SSD_refresh once SSD_statsBegin attached it.
+// Intervals are between consecutive slot switches of a display, in global
+// timer counts (COUNTS_PER_SECOND).
+typedef struct SSD_Stats {
+   XTime last[SSD_MAX_DISPLAYS];
+   u32 samples;
+   u32 min;
+   u32 max;
+   u64 sum;
+   u32 expected;
+   u32 bucket_shift;
+   u32 histogram[SSD_JITTER_BUCKETS];
+} SSD_Stats;
+
+// Chain of Pmod SSDs multiplexed from a periodic interrupt. frame holds a
+// front and a back buffer of segment patterns, front selects the one being
+// shown. Each SSD_refresh call advances the digit slot of one display, in
+// turn; a writer fills the back buffer and publishes it with SSD_swap.
+// While a marquee is running (marquee_len != 0) the digits are taken from
+// the precompiled marquee stream at marquee_pos instead of the frame.
+typedef struct PmodSSD {
+   SSD_Display display[SSD_MAX_DISPLAYS];
+   u32 num_displays;
+   u32 num_digits;
+   u32 next_display;
+   volatile u8 frame[2][SSD_MAX_DIGITS];
+   volatile u32 front;
+   volatile u8 brightness[SSD_MAX_DIGITS];
+   volatile u32 blanking;
+   const u8 *volatile marquee;
+   volatile u32 marquee_len;
+   u32 marquee_pos;
+   u32 marquee_frames;
+   u32 marquee_count;
+   SSD_Stats *stats;
+} PmodSSD;
+
+/************************** Function Definitions ************************/
+
+void SSD_begin(PmodSSD *InstancePtr, XGpio *GpioPtr, unsigned channel);
+XStatus SSD_addDisplay(PmodSSD *InstancePtr, XGpio *GpioPtr, unsigned channel);
+void SSD_setWiring(PmodSSD *InstancePtr, u32 display, u32 segment_mask,
+      u32 select_shift);
+void SSD_setDigit(PmodSSD *InstancePtr, u32 digit, u8 segments);
+XStatus SSD_setNumber(PmodSSD *InstancePtr, u32 digit, u32 width, u32 value,
+      u32 base, u32 point);
+void SSD_swap(PmodSSD *InstancePtr);
+void SSD_setBrightness(PmodSSD *InstancePtr, u32 digit, u32 level);
+void SSD_setBlanking(PmodSSD *InstancePtr, u32 ticks);
+void SSD_refresh(PmodSSD *InstancePtr);
+u32 SSD_marqueeCompile(PmodSSD *InstancePtr, const char *text, u8 *stream,
+      u32 size);
+void SSD_marqueeStart(PmodSSD *InstancePtr, const u8 *stream, u32 length,
+      u32 frames_per_step);
+void SSD_marqueeStop(PmodSSD *InstancePtr);
+void SSD_statsBegin(PmodSSD *InstancePtr, SSD_Stats *StatsPtr, u32 expected,
+      u32 bucket_shift);
+void SSD_statsReset(SSD_Stats *StatsPtr);
+u32 SSD_decode(u8 key_value, u8 cathode);
+
+#endif // PMODSSD_H
@@ -0,0 +1,202 @@
+#include "rgbpwm.h"
+
+/************************** Constant Definitions ************************/
+
+// Duty of each 8-bit color value, gamma 2.2: the eye sees equal color steps
+// as equal brightness steps
+static const u8 RGBPWM_gamma[256] = {
+     0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+     1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+     3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+     6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+    12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+    20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+    30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+    42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+    56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+    73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+    91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+   113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+   137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+   163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+   192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+   223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+/************************** Function Definitions ************************/
+
+/* -------------------------------------------------------------------- */
+/*** void RGBPWM_begin(RGBPWM *InstancePtr, ShadowGpio *OutPtr,
+**         unsigned channel)
+**
+**   Parameters:
+**      InstancePtr: A RGBPWM to start
+**      OutPtr:      The shadowed GPIO the LED is wired to
+**      channel:     GPIO channel of the LED
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Initialize the engine with the LED off. RGBPWM_tick must then be
+**      called at a fixed rate, normally from the hardware timer interrupt;
+**      the PWM frequency is that rate divided by RGBPWM_PERIOD.
+*/
+void RGBPWM_begin(RGBPWM *InstancePtr, ShadowGpio *OutPtr, unsigned channel) {
+   InstancePtr->OutPtr = OutPtr;
+   InstancePtr->channel = channel;
+   InstancePtr->front = 0;
+   InstancePtr->gate = 0xFF;
+   InstancePtr->tick = 0;
+   InstancePtr->level = 0;
+   // Never a channel value, so the first tick writes the GPIO
+   InstancePtr->out = 0xFFFFFFFF;
+   RGBPWM_setColor(InstancePtr, 0);
+}
+
+/* -------------------------------------------------------------------- */
+/*** void RGBPWM_setColor(RGBPWM *InstancePtr, u32 rgb)
+**
+**   Parameters:
+**      InstancePtr: A RGBPWM to use
+**      rgb:         Color as 0xRRGGBB
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Gamma-correct the three channels and precompute the transitions of
+**      a period: every lit channel goes on at tick 0, and the channels go
+**      off in order of increasing duty, those with equal duty together.
+**      The schedule is written to the back buffer and published with a
+**      single store of the front index; the interrupt picks it up at the
+**      start of its next period. Calls must not overlap, so the color has
+**      one writer at a time: a task, or an interrupt while the task leaves
+**      the LED to it. RGBPWM_tick and RGBPWM_setGate may run at any time.
+*/
+void RGBPWM_setColor(RGBPWM *InstancePtr, u32 rgb) {
+   const u32 bits[3] = { RGBPWM_RED, RGBPWM_GREEN, RGBPWM_BLUE };
+   u32 duty[3];
+   u32 value = 0;
+   u32 step = 0;
+   u32 values;
+   u32 shift = 8;
+   u32 last = 0;
+   u32 next, i;
+
+   duty[0] = RGBPWM_gamma[(rgb >> 16) & 0xFF];
+   duty[1] = RGBPWM_gamma[(rgb >> 8) & 0xFF];
+   duty[2] = RGBPWM_gamma[rgb & 0xFF];
+   for (i = 0; i < 3; i++)
+      if (duty[i] != 0)
+         value |= bits[i];
+   values = value;
+
+   // Lowest duty above the last one handled, until all channels are off or
+   // only fully lit ones are left
+   while (1) {
+      next = RGBPWM_PERIOD;
+      for (i = 0; i < 3; i++)
+         if (duty[i] > last && duty[i] < next)
+            next = duty[i];
+      if (next == RGBPWM_PERIOD)
+         break;
+      for (i = 0; i < 3; i++)
+         if (duty[i] == next)
+            value &= ~bits[i];
+      step |= next << shift;
+      values |= value << shift;
+      shift += 8;
+      last = next;
+   }
+   for (; shift < 32; shift += 8)
+      step |= RGBPWM_PERIOD << shift;
+
+   i = InstancePtr->front ^ 1;
+   InstancePtr->schedule[i].step = step;
+   InstancePtr->schedule[i].value = values;
+   InstancePtr->front = i;
+   InstancePtr->color = rgb;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void RGBPWM_setGate(RGBPWM *InstancePtr, u32 on)
+**
+**   Parameters:
+**      InstancePtr: A RGBPWM to use
+**      on:          Nonzero to let the PWM output through, zero to keep
+**                   the LED off
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Switch the output without touching the schedule; the next tick
+**      applies it. Safe to call from the interrupt that runs RGBPWM_tick.
+*/
+void RGBPWM_setGate(RGBPWM *InstancePtr, u32 on) {
+   InstancePtr->gate = on ? 0xFF : 0;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void RGBPWM_tick(RGBPWM *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A RGBPWM to advance
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Advance the PWM by one tick. Only the next transition is compared,
+**      and the schedule is consumed by shifting it, so every tick costs
+**      the same whatever the color. The gated level is written only when
+**      it changes, so at most one GPIO write is made.
+*/
+void RGBPWM_tick(RGBPWM *InstancePtr) {
+   u32 tick = InstancePtr->tick;
+   u32 front, out;
+
+   if (tick == 0) {
+      front = InstancePtr->front;
+      InstancePtr->run.step = InstancePtr->schedule[front].step;
+      InstancePtr->run.value = InstancePtr->schedule[front].value;
+   }
+   if ((InstancePtr->run.step & 0xFF) == tick) {
+      InstancePtr->level = InstancePtr->run.value & 0xFF;
+      InstancePtr->run.step = (InstancePtr->run.step >> 8)
+            | (RGBPWM_PERIOD << 24);
+      InstancePtr->run.value >>= 8;
+   }
+   out = InstancePtr->level & InstancePtr->gate;
+   if (out != InstancePtr->out) {
+      InstancePtr->out = out;
+      SGPIO_write(InstancePtr->OutPtr, InstancePtr->channel, out);
+   }
+   InstancePtr->tick = tick + 1 < RGBPWM_PERIOD ? tick + 1 : 0;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 RGBPWM_hue(u32 hue)
+**
+**   Parameters:
+**      hue: Position on the color wheel, 0 to RGBPWM_HUE_RANGE - 1; 0 is
+**           red, 512 green and 1024 blue
+**
+**   Return Value:
+**      rgb: The fully saturated color of that hue as 0xRRGGBB
+*/
+u32 RGBPWM_hue(u32 hue) {
+   u32 f = hue & 0xFF;
+   u32 r, g, b;
+
+   switch ((hue >> 8) % 6) {
+   case 0:  r = 0xFF;     g = f;        b = 0;        break;
+   case 1:  r = 0xFF - f; g = 0xFF;     b = 0;        break;
+   case 2:  r = 0;        g = 0xFF;     b = f;        break;
+   case 3:  r = 0;        g = 0xFF - f; b = 0xFF;     break;
+   case 4:  r = f;        g = 0;        b = 0xFF;     break;
+   default: r = 0xFF;     g = 0;        b = 0xFF - f; break;
+   }
+   return (r << 16) | (g << 8) | b;
+}
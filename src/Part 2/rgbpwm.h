@@ -0,0 +1,60 @@
+#ifndef RGBPWM_H
+#define RGBPWM_H
+
+/****************************** Include Files ***************************/
+
+#include "xil_types.h"
+#include "shadowgpio.h"
+
+/************************** Constant Definitions ************************/
+
+// Timer ticks per PWM period. A channel at duty d is on for d of them, so
+// duty 255 is fully on and needs no transition to off.
+#define RGBPWM_PERIOD 255
+
+// GPIO bit of each color on the RGB LED channel
+#define RGBPWM_BLUE  0x1
+#define RGBPWM_GREEN 0x2
+#define RGBPWM_RED   0x4
+
+// Hues accepted by RGBPWM_hue: six sectors of 256 steps around the wheel
+#define RGBPWM_HUE_RANGE (6 * 256)
+
+/**************************** Type Definitions **************************/
+
+// Transitions of one PWM period, packed one byte per transition with the
+// first one in the low byte: at tick step[i] the channel is set to value[i].
+// Unused bytes of step hold RGBPWM_PERIOD, which is never reached.
+typedef struct RGBPWM_Schedule {
+   u32 step;
+   u32 value;
+} RGBPWM_Schedule;
+
+// Software PWM of the three color channels of an RGB LED, run from a
+// hardware timer interrupt. RGBPWM_setColor precomputes the schedule into
+// the back buffer and publishes it by swapping front; RGBPWM_tick copies
+// the front schedule into run at the start of every period, so a new
+// color always starts with a whole period. gate masks the PWM output at
+// any tick, for blinking faster than the PWM period.
+typedef struct RGBPWM {
+   ShadowGpio *OutPtr;
+   unsigned channel;
+   volatile RGBPWM_Schedule schedule[2];
+   volatile u32 front;
+   volatile u32 gate;
+   RGBPWM_Schedule run;
+   u32 tick;
+   u32 level;
+   u32 out;
+   u32 color;
+} RGBPWM;
+
+/************************** Function Definitions ************************/
+
+void RGBPWM_begin(RGBPWM *InstancePtr, ShadowGpio *OutPtr, unsigned channel);
+void RGBPWM_setColor(RGBPWM *InstancePtr, u32 rgb);
+void RGBPWM_setGate(RGBPWM *InstancePtr, u32 on);
+void RGBPWM_tick(RGBPWM *InstancePtr);
+u32 RGBPWM_hue(u32 hue);
+
+#endif // RGBPWM_H
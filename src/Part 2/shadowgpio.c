@@ -0,0 +1,85 @@
+#include "shadowgpio.h"
+
+/************************** Function Definitions ************************/
+
+/* -------------------------------------------------------------------- */
+/*** void SGPIO_begin(ShadowGpio *InstancePtr, XGpio *GpioPtr)
+**
+**   Parameters:
+**      InstancePtr: A ShadowGpio to initialize
+**      GpioPtr:     The initialized XGpio device it writes to
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Attach the wrapper to a GPIO device. The shadow starts invalid, so
+**      the first write to each channel always reaches the hardware.
+*/
+void SGPIO_begin(ShadowGpio *InstancePtr, XGpio *GpioPtr) {
+   InstancePtr->gpio = GpioPtr;
+   InstancePtr->writes = 0;
+   InstancePtr->avoided = 0;
+   SGPIO_invalidate(InstancePtr);
+}
+
+/* -------------------------------------------------------------------- */
+/*** void SGPIO_write(ShadowGpio *InstancePtr, unsigned channel, u32 data)
+**
+**   Parameters:
+**      InstancePtr: A ShadowGpio to use
+**      channel:     GPIO channel, 1 or 2
+**      data:        Value to drive on the channel
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Write data to the channel unless it is already driving it. Writes
+**      that reach the bus are counted in InstancePtr->writes, skipped ones
+**      in InstancePtr->avoided.
+*/
+void SGPIO_write(ShadowGpio *InstancePtr, unsigned channel, u32 data) {
+   u32 i = channel - 1;
+
+   if ((InstancePtr->valid & (1 << i)) && InstancePtr->shadow[i] == data) {
+      InstancePtr->avoided++;
+      return;
+   }
+
+   XGpio_DiscreteWrite(InstancePtr->gpio, channel, data);
+   InstancePtr->shadow[i] = data;
+   InstancePtr->valid |= 1 << i;
+   InstancePtr->writes++;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 SGPIO_read(ShadowGpio *InstancePtr, unsigned channel)
+**
+**   Parameters:
+**      InstancePtr: A ShadowGpio to use
+**      channel:     GPIO channel, 1 or 2
+**
+**   Return Value:
+**      data: The value last written to the channel, without a bus access
+*/
+u32 SGPIO_read(ShadowGpio *InstancePtr, unsigned channel) {
+   return InstancePtr->shadow[channel - 1];
+}
+
+/* -------------------------------------------------------------------- */
+/*** void SGPIO_invalidate(ShadowGpio *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A ShadowGpio to use
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Forget the shadow values, e.g. after the device was written through
+**      XGpio directly, so that the next write to each channel goes out.
+*/
+void SGPIO_invalidate(ShadowGpio *InstancePtr) {
+   InstancePtr->valid = 0;
+}
@@ -0,0 +1,28 @@
+#ifndef SHADOWGPIO_H
+#define SHADOWGPIO_H
+
+/****************************** Include Files ***************************/
+
+#include "xil_types.h"
+#include "xgpio.h"
+
+/**************************** Type Definitions **************************/
+
+// Output wrapper around an initialized XGpio. Keeps the last value written
+// to each of the two channels and drops writes that would not change it.
+typedef struct ShadowGpio {
+   XGpio *gpio;
+   u32 shadow[2];
+   u32 valid;
+   u32 writes;
+   u32 avoided;
+} ShadowGpio;
+
+/************************** Function Definitions ************************/
+
+void SGPIO_begin(ShadowGpio *InstancePtr, XGpio *GpioPtr);
+void SGPIO_write(ShadowGpio *InstancePtr, unsigned channel, u32 data);
+u32 SGPIO_read(ShadowGpio *InstancePtr, unsigned channel);
+void SGPIO_invalidate(ShadowGpio *InstancePtr);
+
+#endif // SHADOWGPIO_H